@@ -20,8 +20,10 @@
 #define SCFFLD_util_h
 
 // util
+#import <SCCompiledJSON.h>
 #import <SCFileIO.h>
 #import <SCI18nMap.h>
+#import <SCInternTable.h>
 #import <SCLocals.h>
 #import <SCLogger.h>
 #import <SCRegExp.h>
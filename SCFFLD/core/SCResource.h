@@ -19,6 +19,7 @@
 #import <UIKit/UIKit.h>
 #import "SCCompoundURI.h"
 #import "SCURIHandling.h"
+#import "SCTypeConversions.h"
 
 /**
  * An object used to represent a value returned by an internal URI.
@@ -46,6 +47,11 @@
  * @see <SCTypeConversions>.
  */
 - (id)asJSONData;
+/**
+ * Access the resource's JSON representation, interning repeated keys and short values.
+ * @param internTable   The table to intern strings with.
+ */
+- (id)asJSONDataWithInternTable:(SCInternTable *)internTable;
 /// Access the resource's number representation.
 - (NSNumber *)asNumber;
 /// Access the resource's string representation.
@@ -59,6 +65,12 @@
  * @see <SCTypeConversions> for a list of supported representation names.
  */
 - (id)asRepresentation:(NSString *)representation;
+/**
+ * Return the identified resource representation.
+ * Subclasses supporting additional representations should override this method.
+ * @see <SCTypeConversions>.
+ */
+- (id)asRepresentationType:(SCRepresentation)representation;
 /**
  * Return an external URL for the resource.
  * @return Returns _nil_ for the standard resource type.
@@ -50,7 +50,11 @@
 // Access the resource's JSON representation.
 // Returns the string representation parsed as a JSON string.
 - (id)asJSONData {
-    return [SCTypeConversions asJSONData:[self asDefault]];
+    return [self asJSONDataWithInternTable:nil];
+}
+
+- (id)asJSONDataWithInternTable:(SCInternTable *)internTable {
+    return [SCTypeConversions asJSONData:[self asDefault] internTable:internTable];
 }
 
 - (NSNumber *)asNumber {
@@ -78,7 +82,11 @@
 */
 
 - (id)asRepresentation:(NSString *)representation {
-    return [SCTypeConversions value:[self asDefault] asRepresentation:representation];
+    return [self asRepresentationType:[SCTypeConversions representationForName:representation]];
+}
+
+- (id)asRepresentationType:(SCRepresentation)representation {
+    return [SCTypeConversions value:[self asDefault] asRepresentationType:representation];
 }
 
 - (NSURL *)externalURL {
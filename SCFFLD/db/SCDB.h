@@ -19,7 +19,60 @@
 #import <Foundation/Foundation.h>
 #import "SCDBHelper.h"
 #import "SCDBORM.h"
+#import "SCDBRecordCache.h"
+#import "SCDBChangeSet.h"
 #import "SCService.h"
+#import "Q.h"
+
+/// The error domain for asynchronous operation errors.
+#define SCDBErrorDomain     (@"SCDBError")
+/// Error code for an asynchronous operation which was cancelled.
+#define SCDBErrorCancelled  (1)
+/// Error code for an asynchronous operation which failed.
+#define SCDBErrorFailed     (2)
+
+/**
+ * A block performing a database operation asynchronously.
+ * Returns the operation's result; or sets _error_ and returns _nil_ if the operation fails.
+ */
+typedef id (^SCDBAsyncBlock) (NSError **error);
+
+/**
+ * A block for receiving query result rows.
+ * The row dictionary contains the row's non-null column values. Set _stop_ to YES to end the query early.
+ */
+typedef void (^SCDBRowBlock) (NSDictionary *row, BOOL *stop);
+
+/**
+ * A block for reading query result rows directly from the query's result set.
+ * The result set is positioned on the current row; blocks shouldn't step or close it.
+ */
+typedef void (^SCDBResultSetBlock) (SCSqliteResultSet *rs, BOOL *stop);
+
+/// The name of the highlighted snippet column in search results.
+#define SCDBSearchSnippetColumn (@"_snippet")
+/// The name of the rank column in search results; lower values are better matches.
+#define SCDBSearchRankColumn    (@"_rank")
+
+/**
+ * A block for receiving progress updates while a table's initial data is loaded.
+ * _rowCount_ is the number of rows inserted into the table so far.
+ */
+typedef void (^SCDBInitialDataProgressBlock) (NSString *table, NSUInteger rowCount);
+
+/**
+ * A block for observing database changes.
+ * @param changes   The changes made to the database's tables since the previous change set was delivered.
+ */
+typedef void (^SCDBChangeBlock) (SCDBChangeSet *changes);
+
+/// Numeric types for columnar query results.
+typedef NS_ENUM(NSInteger, SCDBColumnType) {
+    /// Column values are read as int64_t values; null values are read as zero.
+    SCDBColumnTypeInt64,
+    /// Column values are read as double values; null values are read as NaN.
+    SCDBColumnTypeDouble
+};
 
 /**
  * A SQL database wrapper.
@@ -30,6 +83,24 @@
     NSDictionary *_taggedTableColumns;
     NSDictionary *_tableColumnNames;
     NSMutableDictionary *_initialData;
+    /// The names of tables whose ID column has a unique index, allowing native upserts.
+    NSSet *_upsertTables;
+    /// Pending asynchronous operations, keyed by promise.
+    NSMapTable *_asyncOperations;
+    /// The full-text search columns of each table declaring them, keyed by table name.
+    NSDictionary *_searchTableColumns;
+    /// The full-text search tokenizer of each table specifying one, keyed by table name.
+    NSDictionary *_searchTableTokenizers;
+    /// Registered change observers.
+    NSMutableArray *_changeObservers;
+    /// Changes waiting to be delivered to change observers.
+    SCDBChangeSet *_pendingChanges;
+    /// A flag indicating that an explicit transaction is open.
+    BOOL _transactionOpen;
+    /// Changes made within the current explicit transaction; delivered once it's committed, discarded if it's rolled back.
+    SCDBChangeSet *_transactionChanges;
+    /// A flag indicating that delivery of the pending changes has been scheduled.
+    BOOL _changeDeliveryScheduled;
 }
 
 /** The database name. */
@@ -38,10 +109,69 @@
 @property (nonatomic, strong) NSNumber *version;
 /** Flag indicating whether to reset the database at startup. */
 @property (nonatomic, assign) BOOL resetDatabase;
-/** Database table schemas + initial data. */
+/**
+ * Database table schemas + initial data.
+ * A table schema may declare indexes in an _indexes_ dictionary keyed by index name; each index
+ * specifies its _columns_ (a list, or a comma separated string), and optionally _unique_, a partial
+ * index _where_ condition, and _since_/_until_ versions. Columns tagged _id_ or _ownerid_ are
+ * indexed automatically.
+ * A table schema's initial _data_ is either a list of records, or a data file resource or path
+ * (relative paths are resolved against the main bundle's resources) which is streamed into the
+ * table when it is created. The file format is indicated by its extension (.json, .ndjson or
+ * .csv), or by the schema's _dataFormat_ property; see SCDBDataLoader.
+ * A table schema may also declare full-text _search_ columns, either as a list of column names or as
+ * a dictionary with _columns_ and an optional FTS5 _tokenize_ option; see searchTable:matching:limit:.
+ * A table schema's _recordCacheSize_ overrides the database's recordCacheSize for the table.
+ */
 @property (nonatomic, strong) NSDictionary *tables;
 /** Object/relational mappings defined for the database. */
 @property (nonatomic, strong) SCDBORM *orm;
+/**
+ * If true then the database uses WAL journal mode, allowing reads to proceed concurrently with writes.
+ * Defaults to YES. Without WAL mode, reads are serialised with writes on a single connection.
+ */
+@property (nonatomic, assign) BOOL walMode;
+/** An optional value for SQLite's synchronous pragma, e.g. "NORMAL" (recommended with WAL mode). */
+@property (nonatomic, strong) NSString *synchronous;
+/** The maximum number of concurrent read connections, when in WAL mode. Defaults to 4. */
+@property (nonatomic, assign) NSUInteger readPoolSize;
+/**
+ * The maximum number of rows written by each multi-row INSERT statement during bulk inserts.
+ * The actual number may be lower, so that statements don't exceed SQLite's parameter limit.
+ * Defaults to 100.
+ */
+@property (nonatomic, assign) NSUInteger bulkInsertRowLimit;
+/**
+ * A block called with progress updates while initial data is loaded from data files.
+ * Called on the thread performing the database migration.
+ */
+@property (nonatomic, copy) SCDBInitialDataProgressBlock initialDataProgressBlock;
+/**
+ * If true then all statements executed by the database are profiled; see _profiler_.
+ * Defaults to NO.
+ */
+@property (nonatomic, assign) BOOL profileQueries;
+/** The execution time, in seconds, above which profiled statements are logged as slow. Defaults to 0.1. */
+@property (nonatomic, assign) NSTimeInterval slowQueryThreshold;
+/** The database's statement profiler, when profileQueries is enabled. */
+@property (nonatomic, strong, readonly) SCSqliteProfiler *profiler;
+/**
+ * The maximum number of records cached for each table with an ID column; see _recordCache_.
+ * Defaults to 0, i.e. no records are cached.
+ */
+@property (nonatomic, assign) NSUInteger recordCacheSize;
+/**
+ * The database's record cache, when records are cached for any table.
+ * Records read by readRecordWithID:fromTable: (and objects read by the ORM's selectKey:mappings:) are
+ * cached, and are invalidated by writes made through this instance: by ID after inserts, upserts,
+ * updates, merges and deletes by ID; by table after deleteFromTable:where: and performUpdate:withParams:
+ * (entirely, if the table written by the SQL can't be determined); and entirely after explicit
+ * transactions. Writes made through other instances, or other connections, aren't seen by the cache.
+ * Cached records are shared, and mustn't be modified. Use the cache's statistics to monitor its hit rate.
+ */
+@property (nonatomic, strong, readonly) SCDBRecordCache *recordCache;
+/** The queue on which asynchronous operation results are delivered. Defaults to the main queue. */
+@property (nonatomic, strong) dispatch_queue_t asyncResultQueue;
 /**
  * The path to an initial copy of the database. If specified, then this will be copied before the
  * database is first used.
@@ -50,41 +180,103 @@
 
 /** Instantiate a new copy of an existing database. */
 - (id)initWithDB:(SCDB *)db;
-/** Begin a DB transaction. */
+/**
+ * Begin a DB transaction.
+ * All writes are performed on a single writer connection; the calling thread holds the writer until the
+ * transaction is committed or rolled back, and writes from other threads wait until then.
+ */
 - (BOOL)beginTransaction;
 /** Commit a DB transaction. */
 - (BOOL)commitTransaction;
 /** Rollback a DB transaction. */
 - (BOOL)rollbackTransaction;
-/** Close the thread's current DB connection. */
+/** Close the database's connections. */
 - (void)closeConnection;
 /** Get the name of the column with the specified tag from the named table. */
 - (NSString *)getColumnWithTag:(NSString *)tag fromTable:(NSString *)table;
 /** Get the record with the specified ID from the named table. */
 - (NSDictionary *)readRecordWithID:(NSString *)identifier fromTable:(NSString *)table;
+/**
+ * Perform a full-text search of a table's search columns.
+ * The query is plain text. Where FTS5 is available, each of its words is matched, as a quoted FTS5
+ * string, against a search table kept up to date by triggers on the table. Result rows are ordered by
+ * rank (bm25) and include a highlighted snippet of the matching text. Where FTS5 isn't available, rows
+ * containing the query text in any search column are returned, without rank or snippet.
+ * @param limit The maximum number of rows to return; or zero for no limit.
+ */
+- (NSArray *)searchTable:(NSString *)table matching:(NSString *)query limit:(NSInteger)limit;
 /** Perform a SQL query with the specified parameters. Returns the query result. */
 - (NSArray *)performQuery:(NSString *)sql withParams:(NSArray *)params;
+/**
+ * Perform a SQL query with the specified parameters, passing each result row to a block as it is read.
+ * Unlike performQuery:withParams:, the full result isn't held in memory.
+ */
+- (void)enumerateQuery:(NSString *)sql params:(NSArray *)params usingBlock:(SCDBRowBlock)block;
+/**
+ * Perform a SQL query, passing each result row to a block in the same reusable row dictionary.
+ * The dictionary is emptied and refilled for each row, so no dictionary is allocated per row;
+ * blocks must copy the row if they need it after returning.
+ */
+- (void)enumerateQuery:(NSString *)sql params:(NSArray *)params reusingRow:(NSMutableDictionary *)row usingBlock:(SCDBRowBlock)block;
+/**
+ * Perform a SQL query, passing the result set to a block once for each result row.
+ * Allows callers to read column values by index, without a row dictionary being created.
+ */
+- (void)enumerateQuery:(NSString *)sql params:(NSArray *)params usingResultSetBlock:(SCDBResultSetBlock)block;
+/**
+ * Perform a query for a list of values of any length, and enumerate the result rows.
+ * The SQL's IN list marker (_(?*)_) is replaced with a list of parameters, and the query is executed
+ * for each chunk of the values; see SCSqliteDB's executeUpdate:parameters:inList:error:.
+ */
+- (void)enumerateQuery:(NSString *)sql params:(NSArray *)params inList:(NSArray *)values usingResultSetBlock:(SCDBResultSetBlock)block;
+/**
+ * Perform a SQL query with the specified parameters and return its result in columnar form.
+ * Returns a dictionary mapping each result column name to an NSData buffer holding one value per result
+ * row, as a C array of the specified type (int64_t or double). This allows numeric data to be aggregated
+ * without a boxed value or dictionary being created per row.
+ */
+- (NSDictionary *)performColumnarQuery:(NSString *)sql withParams:(NSArray *)params columnType:(SCDBColumnType)columnType;
 /** Perform an update on the database using the specified parameters. Returns YES if the update succeeded. */
 - (BOOL)performUpdate:(NSString *)sql withParams:(NSArray *)params;
 /** Return the number of records matching the specified where clause in the specified table. */
 - (NSInteger)countInTable:(NSString *)table where:(NSString *)where;
 /** Return the number of records matching the specified where clause in the specified table. */
 - (NSInteger)countInTable:(NSString *)table where:(NSString *)where withParams:(NSArray *)params;
-/** Insert a list of values into the named table. Each item of the list is inserted as a new record. Returns true if all records are inserted. */
+/**
+ * Insert a list of values into the named table. Each item of the list is inserted as a new record.
+ * The list is inserted within a single transaction (or within the current transaction, if one is open),
+ * with consecutive records that have the same set of columns written together using multi-row inserts.
+ * Returns true if all records are inserted. If the method opened the transaction and any insert fails
+ * then the transaction is rolled back, and no records are inserted.
+ */
 - (BOOL)insertValueList:(NSArray *)valueList intoTable:(NSString *)table;
 /** Insert values into the named table. Returns true if the record is inserted. */
 - (BOOL)insertValues:(NSDictionary *)values intoTable:(NSString *)table;
 /** Insert values into the named table. Returns true if the record is inserted. */
 - (BOOL)insertValues:(NSDictionary *)values intoTable:(NSString *)table db:(SCSqliteDB *)db;
-/** Insert or update a list of values into the named table. Each item of the list is inserted as a new record. Returns true if all records are inserted. */
+/**
+ * Insert or update a list of values into the named table. Each item of the list is inserted as a new record.
+ * The list is written within a single transaction (or within the current transaction, if one is open).
+ * Returns true if all records are inserted. If the method opened the transaction and any write fails
+ * then the transaction is rolled back.
+ */
 - (BOOL)upsertValueList:(NSArray *)valueList intoTable:(NSString *)table;
-/** Insert or update values into the named table. Returns true if the record is inserted. */
+/**
+ * Insert or update values into the named table. Returns true if the record is inserted.
+ * Upserts are performed using a single INSERT ... ON CONFLICT DO UPDATE statement when the SQLite library
+ * supports it and the table's ID column has a unique index (created automatically at startup); otherwise
+ * the record's existence is tested before it is inserted or updated.
+ */
 - (BOOL)upsertValues:(NSDictionary *)values intoTable:(NSString *)table;
 /** Insert or update values into the named table. Returns true if the record is inserted. */
 - (BOOL)upsertValues:(NSDictionary *)values intoTable:(NSString *)table db:(SCSqliteDB *)db;
 /** Update values in the table. Values must include a value for the ID column for the named table. Returns true if the record updated. */
 - (BOOL)updateValues:(NSDictionary *)values inTable:(NSString *)table;
-/** Merge a list of values into the named table. Records are inserted or updated as necessary. Returns true if all records were updated/inserted. */
+/**
+ * Merge a list of values into the named table. Records are inserted or updated as necessary. Returns true if all records were updated/inserted.
+ * Merges differ from upserts in that null values don't overwrite existing column values. The list is written within a
+ * single transaction, using native upserts where available (see upsertValues:intoTable:).
+ */
 - (BOOL)mergeValueList:(NSArray *)valueList intoTable:(NSString *)table;
 /** Delete the identified records from the named table. */
 - (BOOL)deleteIDs:(NSArray *)identifiers fromTable:(NSString *)table;
@@ -93,11 +285,53 @@
 /**
  * Delete all records matching the specified where clause from the specified table.
  * Note: This is intended for use by the DB manifest processor as part of its garbage collection functionality,
- * so observers aren't notified after this operation - they will be notified after the following update.
+ * so key-value observers aren't notified after this operation - they will be notified after the following update.
+ * Change observers are notified of a change to the whole table.
  */
 - (BOOL)deleteFromTable:(NSString *)table where:(NSString *)where;
+/**
+ * Add a change observer.
+ * Changes made through this instance are collected and delivered to observers as a single change set
+ * per run loop cycle of the asyncResultQueue (by default, the main queue). Changes made within an
+ * explicit transaction are delivered once the transaction has been committed, and discarded if it's
+ * rolled back. Only successful writes are reported.
+ * The existing key-value observation of table names is unaffected.
+ * @param tables    The names of the tables to observe; or _nil_ to observe all tables.
+ * @param block     A block called with each change set including an observed table.
+ * @return An observer token, for use with removeChangeObserver:.
+ */
+- (id)addChangeObserverForTables:(NSArray *)tables usingBlock:(SCDBChangeBlock)block;
+/** Remove a change observer. */
+- (void)removeChangeObserver:(id)observer;
 /** Filter a set of named/value pairs to only contains names corresponding to a column name in the target db table. */
 - (NSDictionary *)filterValues:(NSDictionary *)values forTable:(NSString *)table;
+/**
+ * Perform read operations asynchronously.
+ * The block is run on a background thread using a pooled read connection; any SCDB reads made within
+ * the block use the same connection. Returns a promise resolved with the block's result on asyncResultQueue.
+ */
+- (QPromise *)performReadAsync:(SCDBAsyncBlock)block;
+/**
+ * Perform write operations asynchronously.
+ * The block is run on a background thread holding the writer connection. Note that observers of the
+ * tables written to are notified on the background thread.
+ */
+- (QPromise *)performWriteAsync:(SCDBAsyncBlock)block;
+/** Perform a SQL query asynchronously. The returned promise is resolved with the query result. */
+- (QPromise *)performQueryAsync:(NSString *)sql withParams:(NSArray *)params;
+/**
+ * Insert a list of values into the named table asynchronously.
+ * The values are inserted in a single transaction, in chunks of bulkInsertRowLimit rows; a cancelled insert
+ * stops at the next chunk and is rolled back. Observers of the table are notified on asyncResultQueue.
+ * The returned promise is rejected if the insert fails.
+ */
+- (QPromise *)insertValueListAsync:(NSArray *)valueList intoTable:(NSString *)table;
+/**
+ * Cancel an asynchronous operation.
+ * An operation which is running is interrupted (using sqlite3_interrupt). The operation's promise is
+ * rejected with an SCDBErrorCancelled error.
+ */
+- (void)cancelAsync:(QPromise *)promise;
 /** Create and return a new instance of this database connection. */
 - (SCDB *)newInstance;
 
@@ -21,8 +21,90 @@
 #import "NSDictionary+SCValues.h"
 #import "NSDictionary+SC.h"
 #import "NSArray+SC.h"
+#import "SCDBDataLoader.h"
+#import "SCResource.h"
 
 static SCLogger *Logger;
+/// The number of records inserted by each batch when loading initial data from a file.
+static const NSUInteger InitialDataBatchSize = 1000;
+
+/// An asynchronous database operation.
+@interface SCDBAsyncOperation : NSObject
+
+/// The connection the operation is currently running on.
+@property (nonatomic, strong) SCSqliteDB *db;
+/// A flag indicating that the operation has been cancelled; may be read while the operation is running.
+@property (atomic, assign) BOOL cancelled;
+
+@end
+
+@implementation SCDBAsyncOperation
+
+@end
+
+/// A block performing an asynchronous operation on a database connection.
+typedef id (^SCDBAsyncOperationBlock) (SCDBAsyncOperation *operation, SCSqliteDB *db, NSError **error);
+
+/// A registered database change observer.
+@interface SCDBChangeObserver : NSObject
+
+/// The names of the observed tables; or nil if all tables are observed.
+@property (nonatomic, strong) NSSet *tables;
+/// The block called with each change set.
+@property (nonatomic, copy) SCDBChangeBlock block;
+
+@end
+
+@implementation SCDBChangeObserver
+
+@end
+
+/// Return the name of the table written by an INSERT, REPLACE, UPDATE or DELETE statement; or nil.
+static NSString *SCDBTableWrittenBySQL(NSString *sql) {
+    static NSRegularExpression *WriteStatementPattern;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        WriteStatementPattern = [NSRegularExpression regularExpressionWithPattern:@"^\\s*(?:INSERT|REPLACE|UPDATE|DELETE)(?:\\s+OR\\s+\\w+)?(?:\\s+INTO|\\s+FROM)?\\s+(?:\\w+\\.)?[\"\\[`]?(\\w+)"
+                                                                          options:NSRegularExpressionCaseInsensitive
+                                                                            error:nil];
+    });
+    NSTextCheckingResult *match = [WriteStatementPattern firstMatchInString:sql options:0 range:NSMakeRange(0, [sql length])];
+    return match ? [sql substringWithRange:[match rangeAtIndex:1]] : nil;
+}
+
+/**
+ * Convert search text to an FTS5 query.
+ * Each whitespace separated word is quoted as an FTS5 string, so that query syntax characters in the text
+ * are matched literally; all of the words must match.
+ */
+static NSString *SCDBSearchMatchQuery(NSString *text) {
+    NSMutableArray *terms = [NSMutableArray new];
+    for (NSString *word in [text componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]]) {
+        if ([word length]) {
+            NSString *escaped = [word stringByReplacingOccurrencesOfString:@"\"" withString:@"\"\""];
+            [terms addObject:[NSString stringWithFormat:@"\"%@\"", escaped]];
+        }
+    }
+    return [terms componentsJoinedByString:@" "];
+}
+
+/// Escape the LIKE wildcard characters in text with backslashes, for use with ESCAPE '\'.
+static NSString *SCDBEscapeLikePattern(NSString *text) {
+    // Escape the escape character first.
+    text = [text stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"];
+    text = [text stringByReplacingOccurrencesOfString:@"%" withString:@"\\%"];
+    return [text stringByReplacingOccurrencesOfString:@"_" withString:@"\\_"];
+}
+
+/// Modes for writing rows to a table.
+typedef NS_ENUM(NSInteger, SCDBWriteMode) {
+    /// Insert new rows.
+    SCDBWriteModeInsert,
+    /// Insert new rows, or replace the values of existing rows with the same ID.
+    SCDBWriteModeUpsert,
+    /// Insert new rows, or merge non-null values into existing rows with the same ID.
+    SCDBWriteModeMerge
+};
 
 @interface SCDB ()
 
@@ -36,8 +118,51 @@ static SCLogger *Logger;
 - (BOOL)updateValues:(NSDictionary *)values inTable:(NSString *)table db:(SCSqliteDB *)db;
 /** Update multiple record with the specified values in a table. */
 - (BOOL)updateValues:(NSDictionary *)values idColumn:(NSString *)idColumn inTable:(NSString *)table db:(SCSqliteDB *)db;
+/** Insert a list of values into a table. */
+- (BOOL)insertValueList:(NSArray *)valueList intoTable:(NSString *)table db:(SCSqliteDB *)db;
+/** Write a list of values to a table, grouping records with the same columns into multi-row statements. */
+- (BOOL)writeValueList:(NSArray *)valueList intoTable:(NSString *)table mode:(SCDBWriteMode)mode db:(SCSqliteDB *)db;
+/** Write rows with the same set of columns to a table, using multi-row statements. */
+- (BOOL)writeRows:(NSArray *)rows columns:(NSArray *)columns intoTable:(NSString *)table mode:(SCDBWriteMode)mode db:(SCSqliteDB *)db;
+/** Return the name of a table's full-text search table. */
+- (NSString *)searchTableNameForTable:(NSString *)table;
+/** Create any missing full-text search tables and their triggers, and populate them from their tables. */
+- (void)createSearchTablesOnDB:(SCSqliteDB *)db;
+/** Test whether native upserts can be used with a table. */
+- (BOOL)supportsUpsertOnTable:(NSString *)table;
+/** Create unique indexes on the ID columns, and indexes on the owner ID columns, of the database's tables. */
+- (void)createTaggedColumnIndexesOnDB:(SCSqliteDB *)db;
+/**
+ * Perform a block of writes within a transaction.
+ * A new transaction is opened if one isn't already in progress on the connection, and is
+ * committed if the block returns YES, and rolled back otherwise.
+ */
+- (BOOL)performTransactionOnDB:(SCSqliteDB *)db block:(BOOL (^)(void))block;
+/** Perform an asynchronous operation on a read or write connection. */
+- (QPromise *)performAsync:(SCDBAsyncBlock)block write:(BOOL)write;
+/** Perform an asynchronous operation which is passed its operation, so that it can check for cancellation. */
+- (QPromise *)performAsyncOperation:(SCDBAsyncOperationBlock)block write:(BOOL)write;
+/** Release the writer acquired for a transaction commit or rollback, and the writer held by the transaction if it has ended. */
+- (void)releaseWriter:(SCSqliteDB *)db afterTransaction:(BOOL)inTransaction;
 /** Delete records with the specified IDs from the a table. */
 - (BOOL)deleteIDs:(NSArray *)identifiers idColumn:(NSString *)idColumn fromTable:(NSString *)table;
+/// Create the record cache for tables with a non-zero cache size.
+- (void)createRecordCache;
+/**
+ * Invalidate cached records after a list of values is written to a table and, if the write succeeded,
+ * record the changes. Records are invalidated after a failed write too, as it may have been partly applied.
+ */
+- (void)didWriteValueList:(NSArray *)valueList toTable:(NSString *)table succeeded:(BOOL)succeeded;
+/// Invalidate cached records, and record changes if the write succeeded, after rows are written to a table; pass nil IDs if the rows aren't known.
+- (void)didWriteIDs:(NSArray *)identifiers toTable:(NSString *)table succeeded:(BOOL)succeeded;
+/// Add changed rows to the changes pending delivery to change observers; pass nil IDs if the rows aren't known.
+- (void)recordChangedIDs:(NSArray *)identifiers inTable:(NSString *)table;
+/// Schedule delivery of pending changes. Call while synchronized on the change observers.
+- (void)scheduleChangeDelivery;
+/// Deliver pending changes to change observers.
+- (void)deliverChanges;
+/// Move changes made within an explicit transaction to the pending changes if it was committed, or discard them if rolled back.
+- (void)endTransactionChangesCommitted:(BOOL)committed;
 
 @end
 
@@ -45,8 +170,13 @@ static SCLogger *Logger;
 
 - (NSString *)getCreateTableSQLForTable:(NSString *)tableName schema:(NSDictionary *)tableSchema;
 - (NSArray *)getAlterTableSQLForTable:(NSString *)tableName schema:(NSDictionary *)tableSchema from:(NSInteger)oldVersion to:(NSInteger)newVersion;
+- (NSArray *)getCreateIndexSQLForTable:(NSString *)tableName schema:(NSDictionary *)tableSchema version:(NSInteger)version;
+- (NSArray *)getAlterIndexSQLForTable:(NSString *)tableName schema:(NSDictionary *)tableSchema from:(NSInteger)oldVersion to:(NSInteger)newVersion;
+- (NSString *)getCreateIndexSQLForIndex:(NSString *)indexName table:(NSString *)tableName schema:(NSDictionary *)indexSchema;
 - (void)dbInitialize:(SCSqliteDB *)db error:(NSError **)error;
 - (void)addInitialDataForTable:(NSString *)tableName schema:(NSDictionary *)tableSchema;
+- (BOOL)loadInitialDataForTable:(NSString *)tableName withLoader:(SCDBDataLoader *)loader db:(SCSqliteDB *)db error:(NSError **)error;
+- (NSString *)initialDataPathForString:(NSString *)data;
 
 @end
 
@@ -62,7 +192,12 @@ static SCLogger *Logger;
         self.version = @1;
         self.tables = @{};
         self.resetDatabase = NO;
+        self.bulkInsertRowLimit = 100;
+        self.slowQueryThreshold = 0.1;
+        self.walMode = YES;
         _initialData = [NSMutableDictionary new];
+        _asyncOperations = [NSMapTable strongToStrongObjectsMapTable];
+        _changeObservers = [NSMutableArray new];
     }
     return self;
 }
@@ -73,6 +208,19 @@ static SCLogger *Logger;
     self.version = db.version;
     self.tables = db.tables;
     self.orm = db.orm;
+    self.bulkInsertRowLimit = db.bulkInsertRowLimit;
+    self.walMode = db.walMode;
+    self.synchronous = db.synchronous;
+    self.readPoolSize = db.readPoolSize;
+    self.asyncResultQueue = db.asyncResultQueue;
+    self.initialDataProgressBlock = db.initialDataProgressBlock;
+    self.profileQueries = db.profileQueries;
+    self.slowQueryThreshold = db.slowQueryThreshold;
+    _profiler = db.profiler;
+    self.recordCacheSize = db.recordCacheSize;
+    _asyncOperations = [NSMapTable strongToStrongObjectsMapTable];
+    _changeObservers = [NSMutableArray new];
+    _upsertTables = db->_upsertTables;
     return self;
 }
 
@@ -82,11 +230,27 @@ static SCLogger *Logger;
     _dbHelper = [[SCDBHelper alloc] initWithName:_name version:[_version intValue]];
     _dbHelper.delegate = self;
     _dbHelper.initialCopyPath = _initialCopyPath;
+    _dbHelper.walMode = _walMode;
+    _dbHelper.synchronous = _synchronous;
+    if (_readPoolSize > 0) {
+        _dbHelper.readPoolSize = _readPoolSize;
+    }
+    if (_profileQueries) {
+        if (!_profiler) {
+            _profiler = [SCSqliteProfiler new];
+        }
+        _profiler.slowQueryThreshold = _slowQueryThreshold;
+        _dbHelper.profiler = _profiler;
+    }
     if (_resetDatabase) {
         [Logger warn:@"Resetting database %@", _name];
         [_dbHelper deleteDatabase];
     }
-    [_dbHelper getDatabase];
+    [self createRecordCache];
+    [_dbHelper performWrite:^(SCSqliteDB *db) {
+        [self createTaggedColumnIndexesOnDB:db];
+        [self createSearchTablesOnDB:db];
+    }];
 }
 
 #pragma mark - properties
@@ -120,43 +284,121 @@ static SCLogger *Logger;
     }
     _taggedTableColumns = taggedTableColumns;
     _tableColumnNames = tableColumnNames;
+    // Build lookup of table full-text search columns.
+    NSMutableDictionary *searchTableColumns = [NSMutableDictionary new];
+    NSMutableDictionary *searchTableTokenizers = [NSMutableDictionary new];
+    for (id tableName in [tables allKeys]) {
+        id search = tables[tableName][@"search"];
+        if ([search isKindOfClass:[NSDictionary class]]) {
+            NSString *tokenize = [search getValueAsString:@"tokenize"];
+            if (tokenize) {
+                searchTableTokenizers[tableName] = tokenize;
+            }
+            search = search[@"columns"];
+        }
+        if ([search isKindOfClass:[NSString class]]) {
+            search = [(NSString *)search componentsSeparatedByString:@","];
+        }
+        if ([search isKindOfClass:[NSArray class]] && [search count] > 0) {
+            searchTableColumns[tableName] = search;
+        }
+    }
+    _searchTableColumns = searchTableColumns;
+    _searchTableTokenizers = searchTableTokenizers;
 }
 
 #pragma mark - Public/private methods
 
 - (BOOL)beginTransaction {
-    BOOL ok = YES;
+    // The writer is held by the current thread until the transaction is committed or rolled back.
+    SCSqliteDB *db = [_dbHelper acquireWriter];
+    if (!db) {
+        return NO;
+    }
     NSError *error = nil;
-    SCSqliteDB *db = [_dbHelper getDatabase];
-    [db beginTransaction:&error];
-    if (error) {
+    if (![db beginTransaction:&error]) {
         [Logger error:@"Transaction open failed %@", error];
-        ok = NO;
+        [_dbHelper releaseWriter];
+        return NO;
     }
-    return ok;
+    @synchronized (_changeObservers) {
+        // The transaction's change set is only created once a change is recorded for an observer.
+        _transactionOpen = YES;
+    }
+    return YES;
 }
 
 - (BOOL)commitTransaction {
     BOOL ok = YES;
     NSError *error = nil;
-    SCSqliteDB *db = [_dbHelper getDatabase];
-    [db commitTransaction:&error];
-    if (error) {
+    SCSqliteDB *db = [_dbHelper acquireWriter];
+    BOOL inTransaction = [db inTransaction];
+    if (![db commitTransaction:&error]) {
         [Logger error:@"Transaction commit failed %@", error];
         ok = NO;
     }
-    return ok;
+    BOOL ended = ![db inTransaction];
+    if (ended) {
+        // End the transaction's changes while still holding the writer, so that writes made by other
+        // threads once it's released aren't filed under the ended transaction.
+        [self endTransactionChangesCommitted:ok];
+    }
+    [self releaseWriter:db afterTransaction:inTransaction];
+    // Records read on other connections while the transaction was open may have been cached.
+    [_recordCache clear];
+    return ok && db != nil;
 }
 
 - (BOOL)rollbackTransaction {
     BOOL ok = YES;
     NSError *error = nil;
-    SCSqliteDB *db = [_dbHelper getDatabase];
-    [db rollbackTransaction:&error];
-    if (error) {
+    SCSqliteDB *db = [_dbHelper acquireWriter];
+    BOOL inTransaction = [db inTransaction];
+    if (![db rollbackTransaction:&error]) {
         [Logger error:@"Transaction rollback failed %@", error];
         ok = NO;
     }
+    BOOL ended = ![db inTransaction];
+    if (ended) {
+        // End the transaction's changes while still holding the writer, so that writes made by other
+        // threads once it's released aren't filed under the ended transaction.
+        [self endTransactionChangesCommitted:NO];
+    }
+    [self releaseWriter:db afterTransaction:inTransaction];
+    // Records written within the transaction may have been cached.
+    [_recordCache clear];
+    return ok && db != nil;
+}
+
+- (void)releaseWriter:(SCSqliteDB *)db afterTransaction:(BOOL)inTransaction {
+    if (db) {
+        [_dbHelper releaseWriter];
+        // Also release the writer held since the transaction began, if it has now ended.
+        if (inTransaction && ![db inTransaction]) {
+            [_dbHelper releaseWriter];
+        }
+    }
+}
+
+- (BOOL)performTransactionOnDB:(SCSqliteDB *)db block:(BOOL (^)(void))block {
+    if ([db inTransaction]) {
+        // Writes are part of the caller's transaction.
+        return block();
+    }
+    NSError *error = nil;
+    if (![db beginTransaction:&error]) {
+        [Logger error:@"Transaction open failed %@", error];
+        return NO;
+    }
+    BOOL ok = block();
+    if (ok && ![db commitTransaction:&error]) {
+        [Logger error:@"Transaction commit failed %@", error];
+        ok = NO;
+    }
+    // A failed commit may leave the transaction open, so roll back unless the transaction has ended.
+    if (!ok && [db inTransaction] && ![db rollbackTransaction:&error]) {
+        [Logger error:@"Transaction rollback failed %@", error];
+    }
     return ok;
 }
 
@@ -170,8 +412,22 @@ static SCLogger *Logger;
 }
 
 - (NSDictionary *)readRecordWithID:(NSString *)identifier fromTable:(NSString *)table {
-    SCSqliteDB *db = [_dbHelper getDatabase];
-    return [self readRecordWithID:identifier fromTable:table db:db];
+    BOOL cacheable = identifier && [_recordCache cachesTable:table];
+    uint64_t generation = 0;
+    if (cacheable) {
+        NSDictionary *record = [_recordCache recordWithID:identifier inTable:table generation:&generation];
+        if (record) {
+            return record;
+        }
+    }
+    __block NSDictionary *result = nil;
+    [_dbHelper performRead:^(SCSqliteDB *db) {
+        result = [self readRecordWithID:identifier fromTable:table db:db];
+    }];
+    if (cacheable) {
+        [_recordCache setRecord:result withID:identifier inTable:table generation:generation];
+    }
+    return result;
 }
 
 - (NSDictionary *)readRecordWithID:(NSString *)identifier fromTable:(NSString *)table db:(SCSqliteDB *)db {
@@ -207,26 +463,158 @@ static SCLogger *Logger;
     return result;
 }
 
-- (NSArray *)performQuery:(NSString *)sql withParams:(NSArray *)params {
-    NSMutableArray *result = [NSMutableArray new];
-    SCSqliteDB *db = [_dbHelper getDatabase];
-    NSError *error = nil;
-    SCSqliteResultSet *rs = [db executeQuery:sql parameters:params error:&error];
-    if (error) {
-        [Logger error:@"Error performing query: %@", [error localizedDescription]];
+- (NSArray *)searchTable:(NSString *)table matching:(NSString *)query limit:(NSInteger)limit {
+    NSArray *columns = _searchTableColumns[table];
+    if (!columns) {
+        [Logger warn:@"Table %@ has no search columns", table];
+        return @[];
     }
-    else while ([rs next]) {
-        [result addObject:[self readRowFromResultSet:rs]];
+    NSNumber *_limit = [NSNumber numberWithInteger:(limit > 0 ? limit : -1)];
+    if ([SCSqliteDB supportsFTS5]) {
+        NSString *match = SCDBSearchMatchQuery(query);
+        if (![match length]) {
+            return @[];
+        }
+        NSString *ftsTable = [self searchTableNameForTable:table];
+        NSString *sql = [NSString stringWithFormat:@"SELECT %@.*, snippet(%@, -1, '<b>', '</b>', '...', 16) AS %@, bm25(%@) AS %@ FROM %@ JOIN %@ ON %@.rowid=%@.rowid WHERE %@ MATCH ? ORDER BY %@ LIMIT ?",
+                         table,
+                         ftsTable, SCDBSearchSnippetColumn,
+                         ftsTable, SCDBSearchRankColumn,
+                         ftsTable, table, table, ftsTable,
+                         ftsTable,
+                         SCDBSearchRankColumn];
+        return [self performQuery:sql withParams:@[ match, _limit ]];
+    }
+    // FTS5 not available, so fall back to a scan of the search columns.
+    NSMutableArray *terms = [NSMutableArray new];
+    NSMutableArray *params = [NSMutableArray new];
+    NSString *pattern = [NSString stringWithFormat:@"%%%@%%", SCDBEscapeLikePattern(query)];
+    for (NSString *column in columns) {
+        [terms addObject:[NSString stringWithFormat:@"%@ LIKE ? ESCAPE '\\'", column]];
+        [params addObject:pattern];
     }
-    [rs close];
+    [params addObject:_limit];
+    NSString *sql = [NSString stringWithFormat:@"SELECT * FROM %@ WHERE %@ LIMIT ?", table, [terms componentsJoinedByString:@" OR "]];
+    return [self performQuery:sql withParams:params];
+}
+
+- (NSArray *)performQuery:(NSString *)sql withParams:(NSArray *)params {
+    NSMutableArray *result = [NSMutableArray new];
+    [_dbHelper performRead:^(SCSqliteDB *db) {
+        NSError *error = nil;
+        SCSqliteResultSet *rs = [db executeQuery:sql parameters:params error:&error];
+        if (error) {
+            [Logger error:@"Error performing query: %@", [error localizedDescription]];
+        }
+        else while ([rs next]) {
+            [result addObject:[self readRowFromResultSet:rs]];
+        }
+        [rs close];
+    }];
+    return result;
+}
+
+- (void)enumerateQuery:(NSString *)sql params:(NSArray *)params usingBlock:(SCDBRowBlock)block {
+    [self enumerateQuery:sql params:params reusingRow:nil usingBlock:block];
+}
+
+- (void)enumerateQuery:(NSString *)sql params:(NSArray *)params reusingRow:(NSMutableDictionary *)row usingBlock:(SCDBRowBlock)block {
+    [self enumerateQuery:sql params:params usingResultSetBlock:^(SCSqliteResultSet *rs, BOOL *stop) {
+        if (row) {
+            [row removeAllObjects];
+            [rs readRowInto:row];
+            block(row, stop);
+        }
+        else {
+            block([self readRowFromResultSet:rs], stop);
+        }
+    }];
+}
+
+- (void)enumerateQuery:(NSString *)sql params:(NSArray *)params usingResultSetBlock:(SCDBResultSetBlock)block {
+    [_dbHelper performRead:^(SCSqliteDB *db) {
+        NSError *error = nil;
+        SCSqliteResultSet *rs = [db executeQuery:sql parameters:params error:&error];
+        if (error) {
+            [Logger error:@"Error performing query: %@", [error localizedDescription]];
+        }
+        else {
+            BOOL stop = NO;
+            while (!stop && [rs next]) {
+                // Release each row's objects before reading the next.
+                @autoreleasepool {
+                    block(rs, &stop);
+                }
+            }
+        }
+        [rs close];
+    }];
+}
+
+- (void)enumerateQuery:(NSString *)sql params:(NSArray *)params inList:(NSArray *)values usingResultSetBlock:(SCDBResultSetBlock)block {
+    [_dbHelper performRead:^(SCSqliteDB *db) {
+        NSError *error = nil;
+        if (![db enumerateQuery:sql parameters:params inList:values usingBlock:block error:&error]) {
+            [Logger error:@"Error performing query: %@", [error localizedDescription]];
+        }
+    }];
+}
+
+- (NSDictionary *)performColumnarQuery:(NSString *)sql withParams:(NSArray *)params columnType:(SCDBColumnType)columnType {
+    NSMutableDictionary *result = [NSMutableDictionary new];
+    [_dbHelper performRead:^(SCSqliteDB *db) {
+        NSError *error = nil;
+        SCSqliteResultSet *rs = [db executeQuery:sql parameters:params error:&error];
+        if (error) {
+            [Logger error:@"Error performing query: %@", [error localizedDescription]];
+        }
+        else {
+            NSInteger colCount = rs.columnCount;
+            NSMutableArray *columns = [[NSMutableArray alloc] initWithCapacity:colCount];
+            for (NSInteger idx = 0; idx < colCount; idx++) {
+                NSMutableData *column = [NSMutableData new];
+                [columns addObject:column];
+                result[[rs columnName:idx]] = column;
+            }
+            while ([rs next]) {
+                for (NSInteger idx = 0; idx < colCount; idx++) {
+                    if (columnType == SCDBColumnTypeInt64) {
+                        int64_t value = [rs columnValueAsInt64:idx];
+                        [columns[idx] appendBytes:&value length:sizeof(value)];
+                    }
+                    else {
+                        double value = [rs columnValueAsDouble:idx];
+                        [columns[idx] appendBytes:&value length:sizeof(value)];
+                    }
+                }
+            }
+        }
+        [rs close];
+    }];
     return result;
 }
 
 - (BOOL)performUpdate:(NSString *)sql withParams:(NSArray *)params {
-    SCSqliteDB *db = [_dbHelper getDatabase];
-    NSError *error = nil;
-    [db executeUpdate:sql parameters:params error:&error];
-    if (!error) {
+    __block NSError *error = nil;
+    __block BOOL updated = NO;
+    BOOL ok = [_dbHelper performWrite:^(SCSqliteDB *db) {
+        updated = [db executeUpdate:sql parameters:params error:&error];
+    }];
+    // The rows affected by the update are unknown.
+    BOOL succeeded = ok && updated;
+    NSString *table = SCDBTableWrittenBySQL(sql);
+    if (table) {
+        [self didWriteIDs:nil toTable:table succeeded:succeeded];
+    }
+    else {
+        [_recordCache clear];
+        if (succeeded) {
+            for (NSString *name in _tables) {
+                [self recordChangedIDs:nil inTable:name];
+            }
+        }
+    }
+    if (succeeded) {
         return YES;
     }
     [Logger error:@"Executing update: %@", [error localizedDescription]];
@@ -249,33 +637,217 @@ static SCLogger *Logger;
 }
 
 - (NSDictionary *)readRowFromResultSet:(SCSqliteResultSet *)rs {
-    NSMutableDictionary *result = [NSMutableDictionary new];
-    NSInteger colCount = rs.columnCount;
-    for (NSInteger idx = 0; idx < colCount; idx++) {
-        if (![rs isColumnValueNull:idx]) {
-            NSString *name = [rs columnName:idx];
-            id value = [rs columnValue:idx];
-            [result setObject:value forKey:name];
-        }
-    }
+    NSMutableDictionary *result = [[NSMutableDictionary alloc] initWithCapacity:rs.columnCount];
+    [rs readRowInto:result];
     return result;
 }
 
 - (BOOL)insertValueList:(NSArray *)valueList intoTable:(NSString *)table {
-    SCSqliteDB *db = [_dbHelper getDatabase];
-    BOOL result = YES;
+    __block BOOL result = NO;
     [self willChangeValueForKey:table];
-    for (NSDictionary *values in valueList) {
-        result &= [self insertValues:values intoTable:table db:db];
-    }
+    [_dbHelper performWrite:^(SCSqliteDB *db) {
+        result = [self insertValueList:valueList intoTable:table db:db];
+    }];
+    [self didWriteValueList:valueList toTable:table succeeded:result];
     [self didChangeValueForKey:table];
     return result;
 }
 
+- (BOOL)insertValueList:(NSArray *)valueList intoTable:(NSString *)table db:(SCSqliteDB *)db {
+    return [self writeValueList:valueList intoTable:table mode:SCDBWriteModeInsert db:db];
+}
+
+- (BOOL)writeValueList:(NSArray *)valueList intoTable:(NSString *)table mode:(SCDBWriteMode)mode db:(SCSqliteDB *)db {
+    return [self performTransactionOnDB:db block:^BOOL{
+        // Group consecutive records with the same columns into runs, and insert each run together.
+        NSMutableArray *run = [NSMutableArray new];
+        NSArray *runColumns = nil;
+        for (NSDictionary *values in valueList) {
+            NSDictionary *filteredValues = [self filterValues:values forTable:table];
+            if ([filteredValues count] == 0) {
+                continue;
+            }
+            NSArray *columns = [[filteredValues allKeys] sortedArrayUsingSelector:@selector(compare:)];
+            if (runColumns && ![columns isEqualToArray:runColumns]) {
+                if (![self writeRows:run columns:runColumns intoTable:table mode:mode db:db]) {
+                    return NO;
+                }
+                [run removeAllObjects];
+            }
+            runColumns = columns;
+            [run addObject:filteredValues];
+        }
+        return [run count] == 0 || [self writeRows:run columns:runColumns intoTable:table mode:mode db:db];
+    }];
+}
+
+- (BOOL)writeRows:(NSArray *)rows columns:(NSArray *)columns intoTable:(NSString *)table mode:(SCDBWriteMode)mode db:(SCSqliteDB *)db {
+    NSUInteger rowCount = [rows count];
+    NSUInteger columnCount = [columns count];
+    // Limit the rows per statement so that the statement's parameters are within SQLite's limit.
+    NSUInteger rowLimit = MIN(_bulkInsertRowLimit, (NSUInteger)[db maxParameterCount] / columnCount);
+    rowLimit = MAX(rowLimit, 1);
+    NSString *fields = [columns componentsJoinedByString:@","];
+    NSString *placeholders = [NSString stringWithFormat:@"(%@)", [[NSArray arrayWithItem:@"?" repeated:columnCount] componentsJoinedByString:@","]];
+    NSString *conflictClause = @"";
+    NSString *idColumn = [self getColumnWithTag:@"id" fromTable:table];
+    if (mode != SCDBWriteModeInsert && [columns containsObject:idColumn]) {
+        // Update existing records with the same ID; merges only update with non-null values.
+        NSMutableArray *assignments = [[NSMutableArray alloc] initWithCapacity:columnCount];
+        for (NSString *column in columns) {
+            if ([column isEqualToString:idColumn]) {
+                continue;
+            }
+            NSString *format = (mode == SCDBWriteModeMerge) ? @"%@=COALESCE(excluded.%@,%@)" : @"%@=excluded.%@";
+            [assignments addObject:[NSString stringWithFormat:format, column, column, column]];
+        }
+        if ([assignments count] > 0) {
+            conflictClause = [NSString stringWithFormat:@" ON CONFLICT(%@) DO UPDATE SET %@", idColumn, [assignments componentsJoinedByString:@","]];
+        }
+        else {
+            conflictClause = [NSString stringWithFormat:@" ON CONFLICT(%@) DO NOTHING", idColumn];
+        }
+    }
+    // Full size chunks all use the same SQL, and so reuse the same cached prepared statement.
+    NSString *chunkSQL = nil;
+    for (NSUInteger start = 0; start < rowCount; start += rowLimit) {
+        NSUInteger count = MIN(rowLimit, rowCount - start);
+        NSString *sql = (count == rowLimit) ? chunkSQL : nil;
+        if (!sql) {
+            NSString *values = [[NSArray arrayWithItem:placeholders repeated:count] componentsJoinedByString:@","];
+            sql = [NSString stringWithFormat:@"INSERT INTO %@ (%@) VALUES %@%@", table, fields, values, conflictClause];
+            if (count == rowLimit) {
+                chunkSQL = sql;
+            }
+        }
+        NSMutableArray *params = [[NSMutableArray alloc] initWithCapacity:count * columnCount];
+        for (NSUInteger idx = start; idx < start + count; idx++) {
+            NSDictionary *values = rows[idx];
+            for (id column in columns) {
+                [params addObject:values[column]];
+            }
+        }
+        NSError *error = nil;
+        if (![db executeUpdate:sql parameters:params error:&error]) {
+            [Logger error:@"Error writing values: %@", [error localizedDescription]];
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (BOOL)supportsUpsertOnTable:(NSString *)table {
+    return [_upsertTables containsObject:table];
+}
+
+- (void)createTaggedColumnIndexesOnDB:(SCSqliteDB *)db {
+    NSMutableSet *upsertTables = [NSMutableSet new];
+    BOOL supportsUpsert = [SCSqliteDB supportsUpsert];
+    for (NSString *table in _taggedTableColumns) {
+        NSString *idColumn = [self getColumnWithTag:@"id" fromTable:table];
+        NSString *ownerIDColumn = [self getColumnWithTag:@"ownerid" fromTable:table];
+        if (!(idColumn || ownerIDColumn)) {
+            continue;
+        }
+        NSError *error = nil;
+        SCSqliteResultSet *rs = [db executeQuery:@"SELECT count(*) FROM sqlite_master WHERE type='table' AND name=?"
+                                      parameters:@[ table ]
+                                           error:&error];
+        BOOL exists = !error && [rs next] && [rs columnValueAsInteger:0] > 0;
+        [rs close];
+        if (!exists) {
+            continue;
+        }
+        if (ownerIDColumn) {
+            // Index owner IDs, which are used to join collection relations to their owners.
+            NSString *sql = [NSString stringWithFormat:@"CREATE INDEX IF NOT EXISTS %@_%@_idx ON %@ (%@)", table, ownerIDColumn, table, ownerIDColumn];
+            if (![db executeUpdate:sql parameters:nil error:&error]) {
+                [Logger warn:@"Unable to create index on %@.%@: %@", table, ownerIDColumn, [error localizedDescription]];
+                error = nil;
+            }
+        }
+        if (!idColumn) {
+            continue;
+        }
+        NSString *sql = [NSString stringWithFormat:@"CREATE UNIQUE INDEX IF NOT EXISTS %@_%@_unique ON %@ (%@)", table, idColumn, table, idColumn];
+        if (![db executeUpdate:sql parameters:nil error:&error]) {
+            // Most likely the table already contains duplicate IDs.
+            [Logger warn:@"Unable to create unique index on %@.%@: %@", table, idColumn, [error localizedDescription]];
+        }
+        else if (supportsUpsert) {
+            [upsertTables addObject:table];
+        }
+    }
+    _upsertTables = upsertTables;
+}
+
+- (NSString *)searchTableNameForTable:(NSString *)table {
+    return [NSString stringWithFormat:@"%@_fts", table];
+}
+
+- (void)createSearchTablesOnDB:(SCSqliteDB *)db {
+    if (![_searchTableColumns count]) {
+        return;
+    }
+    if (![SCSqliteDB supportsFTS5]) {
+        [Logger warn:@"FTS5 not available, table searches will scan search columns"];
+        return;
+    }
+    for (NSString *table in _searchTableColumns) {
+        NSString *ftsTable = [self searchTableNameForTable:table];
+        NSError *error = nil;
+        SCSqliteResultSet *rs = [db executeQuery:@"SELECT name FROM sqlite_master WHERE type='table' AND name IN (?,?)"
+                                      parameters:@[ table, ftsTable ]
+                                           error:&error];
+        BOOL tableExists = NO, ftsTableExists = NO;
+        while (!error && [rs next]) {
+            NSString *name = [rs columnValue:0];
+            tableExists |= [table isEqualToString:name];
+            ftsTableExists |= [ftsTable isEqualToString:name];
+        }
+        [rs close];
+        if (!tableExists || ftsTableExists) {
+            continue;
+        }
+        // Create an external content search table, kept in step with the table by triggers.
+        NSArray *columns = _searchTableColumns[table];
+        NSString *cols = [columns componentsJoinedByString:@","];
+        NSString *newCols = [NSString stringWithFormat:@"new.%@", [columns componentsJoinedByString:@",new."]];
+        NSString *oldCols = [NSString stringWithFormat:@"old.%@", [columns componentsJoinedByString:@",old."]];
+        NSString *tokenize = _searchTableTokenizers[table];
+        NSString *options = tokenize ? [NSString stringWithFormat:@",tokenize='%@'", tokenize] : @"";
+        NSString *insert = [NSString stringWithFormat:@"INSERT INTO %@(rowid,%@) VALUES (new.rowid,%@);", ftsTable, cols, newCols];
+        NSString *delete = [NSString stringWithFormat:@"INSERT INTO %@(%@,rowid,%@) VALUES ('delete',old.rowid,%@);", ftsTable, ftsTable, cols, oldCols];
+        NSArray *sqls = @[
+            [NSString stringWithFormat:@"CREATE VIRTUAL TABLE %@ USING fts5(%@,content='%@',content_rowid='rowid'%@)", ftsTable, cols, table, options],
+            [NSString stringWithFormat:@"CREATE TRIGGER IF NOT EXISTS %@_insert AFTER INSERT ON %@ BEGIN %@ END", ftsTable, table, insert],
+            [NSString stringWithFormat:@"CREATE TRIGGER IF NOT EXISTS %@_delete AFTER DELETE ON %@ BEGIN %@ END", ftsTable, table, delete],
+            [NSString stringWithFormat:@"CREATE TRIGGER IF NOT EXISTS %@_update AFTER UPDATE ON %@ BEGIN %@ %@ END", ftsTable, table, delete, insert],
+            [NSString stringWithFormat:@"INSERT INTO %@(%@) VALUES ('rebuild')", ftsTable, ftsTable]
+        ];
+        BOOL ok = [self performTransactionOnDB:db block:^BOOL{
+            NSError *error = nil;
+            for (NSString *sql in sqls) {
+                if (![db executeUpdate:sql parameters:nil error:&error]) {
+                    [Logger warn:@"Unable to create search table for %@: %@", table, [error localizedDescription]];
+                    return NO;
+                }
+            }
+            return YES;
+        }];
+        if (ok) {
+            [Logger info:@"Created search table for %@", table];
+        }
+    }
+}
+
 - (BOOL)insertValues:(NSDictionary *)values intoTable:(NSString *)table {
-    SCSqliteDB *db = [_dbHelper getDatabase];
+    __block BOOL result = NO;
     [self willChangeValueForKey:table];
-    BOOL result = [self insertValues:values intoTable:table db:db];
+    [_dbHelper performWrite:^(SCSqliteDB *db) {
+        result = [self insertValues:values intoTable:table db:db];
+    }];
+    [self didWriteValueList:@[ values ] toTable:table succeeded:result];
     [self didChangeValueForKey:table];
     return result;
 }
@@ -290,8 +862,7 @@ static SCLogger *Logger;
         NSString *sql = [NSString stringWithFormat:@"INSERT INTO %@ (%@) VALUES (%@)", table, fields, placeholders];
         NSArray *params = [NSArray arrayWithDictionaryValues:values forKeys:keys];
         NSError *error = nil;
-        [db executeUpdate:sql parameters:params error:&error];
-        if (error) {
+        if (![db executeUpdate:sql parameters:params error:&error]) {
             [Logger error:@"Error inserting values: %@", [error localizedDescription]];
             ok = NO;
         }
@@ -300,25 +871,48 @@ static SCLogger *Logger;
 }
 
 - (BOOL)upsertValueList:(NSArray *)valueList intoTable:(NSString *)table {
-    SCSqliteDB *db = [_dbHelper getDatabase];
-    BOOL result = YES;
+    __block BOOL result = NO;
     [self willChangeValueForKey:table];
-    for (NSDictionary *values in valueList) {
-        result &= [self upsertValues:values intoTable:table db:db];
-    }
+    [_dbHelper performWrite:^(SCSqliteDB *db) {
+        if ([self supportsUpsertOnTable:table]) {
+            result = [self writeValueList:valueList intoTable:table mode:SCDBWriteModeUpsert db:db];
+        }
+        else {
+            result = [self performTransactionOnDB:db block:^BOOL{
+                for (NSDictionary *values in valueList) {
+                    if (![self upsertValues:values intoTable:table db:db]) {
+                        return NO;
+                    }
+                }
+                return YES;
+            }];
+        }
+    }];
+    [self didWriteValueList:valueList toTable:table succeeded:result];
     [self didChangeValueForKey:table];
     return result;
 }
 
 - (BOOL)upsertValues:(NSDictionary *)values intoTable:(NSString *)table {
-    SCSqliteDB *db = [_dbHelper getDatabase];
+    __block BOOL result = NO;
     [self willChangeValueForKey:table];
-    BOOL result = [self upsertValues:values intoTable:table db:db];
+    [_dbHelper performWrite:^(SCSqliteDB *db) {
+        result = [self upsertValues:values intoTable:table db:db];
+    }];
+    [self didWriteValueList:@[ values ] toTable:table succeeded:result];
     [self didChangeValueForKey:table];
     return result;
 }
 
 - (BOOL)upsertValues:(NSDictionary *)values intoTable:(NSString *)table db:(SCSqliteDB *)db {
+    if ([self supportsUpsertOnTable:table]) {
+        values = [self filterValues:values forTable:table];
+        if ([values count] == 0) {
+            return YES;
+        }
+        NSArray *columns = [[values allKeys] sortedArrayUsingSelector:@selector(compare:)];
+        return [self writeRows:@[ values ] columns:columns intoTable:table mode:SCDBWriteModeUpsert db:db];
+    }
     BOOL update = NO;
     NSString *idColumn = [self getColumnWithTag:@"id" fromTable:table];
     if (idColumn) {
@@ -339,9 +933,12 @@ static SCLogger *Logger;
 }
 
 - (BOOL)updateValues:(NSDictionary *)values inTable:(NSString *)table {
-    SCSqliteDB *db = [_dbHelper getDatabase];
+    __block BOOL result = NO;
     [self willChangeValueForKey:table];
-    BOOL result = [self updateValues:values inTable:table db:db];
+    [_dbHelper performWrite:^(SCSqliteDB *db) {
+        result = [self updateValues:values inTable:table db:db];
+    }];
+    [self didWriteValueList:@[ values ] toTable:table succeeded:result];
     if (result) {
         [self didChangeValueForKey:table];
     }
@@ -382,8 +979,7 @@ static SCLogger *Logger;
     NSString *sql = [NSString stringWithFormat:@"UPDATE %@ SET %@ WHERE %@=?", table, [fields componentsJoinedByString:@","], idColumn ];
     NSError *error = nil;
     BOOL ok = YES;
-    [db executeUpdate:sql parameters:params error:&error];
-    if (error) {
+    if (![db executeUpdate:sql parameters:params error:&error]) {
         [Logger error:@"Error updating values: %@", [error localizedDescription]];
         ok = NO;
     }
@@ -391,22 +987,40 @@ static SCLogger *Logger;
 }
 
 - (BOOL)mergeValueList:(NSArray *)valueList intoTable:(NSString *)table {
-    BOOL result = YES;
+    __block BOOL result = YES;
     NSString *idColumn = [self getColumnWithTag:@"id" fromTable:table];
-    if (idColumn) {
-        SCSqliteDB *db = [_dbHelper getDatabase];
+    if (idColumn && [self supportsUpsertOnTable:table]) {
         [self willChangeValueForKey:table];
-        for (NSDictionary *values in valueList) {
-            id identifier = [values valueForKey:idColumn];
-            NSDictionary *record = [self readRecordWithID:identifier fromTable:table];
-            if (record) {
-                record = [record extendWith:values];
-                result &= [self updateValues:record idColumn:idColumn inTable:table db:db];
-            }
-            else {
-                result &= [self insertValues:values intoTable:table db:db];
-            }
-        }
+        [_dbHelper performWrite:^(SCSqliteDB *db) {
+            result = [self writeValueList:valueList intoTable:table mode:SCDBWriteModeMerge db:db];
+        }];
+        [self didWriteValueList:valueList toTable:table succeeded:result];
+        [self didChangeValueForKey:table];
+    }
+    else if (idColumn) {
+        [self willChangeValueForKey:table];
+        [_dbHelper performWrite:^(SCSqliteDB *db) {
+            // Roll back all records if any record fails to merge.
+            result = [self performTransactionOnDB:db block:^BOOL{
+                for (NSDictionary *values in valueList) {
+                    id identifier = [values valueForKey:idColumn];
+                    NSDictionary *record = [self readRecordWithID:identifier fromTable:table db:db];
+                    BOOL ok;
+                    if (record) {
+                        record = [record extendWith:values];
+                        ok = [self updateValues:record idColumn:idColumn inTable:table db:db];
+                    }
+                    else {
+                        ok = [self insertValues:values intoTable:table db:db];
+                    }
+                    if (!ok) {
+                        return NO;
+                    }
+                }
+                return YES;
+            }];
+        }];
+        [self didWriteValueList:valueList toTable:table succeeded:result];
         [self didChangeValueForKey:table];
     }
     else {
@@ -428,53 +1042,192 @@ static SCLogger *Logger;
 }
 
 - (BOOL)deleteIDs:(NSArray *)identifiers idColumn:(NSString *)idColumn fromTable:(NSString *)table {
-    BOOL result = YES;
+    __block BOOL result = YES;
     if ([identifiers count]) {
-        SCSqliteDB *db = [_dbHelper getDatabase];
         [self willChangeValueForKey:table];
-        NSString *placeholders = [[NSArray arrayWithItem:@"?" repeated:[identifiers count]] componentsJoinedByString:@","];
-        NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ IN (%@)", table, idColumn, placeholders];
-        NSError *error = nil;
-        [db executeUpdate:sql parameters:identifiers error:&error];
-        if (error) {
-            [Logger error:@"Error deleting records: %@", [error localizedDescription]];
-            result = NO;
-        }
+        // IDs are deleted in chunks, so any number can be deleted using a few cached statements.
+        NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ IN %@", table, idColumn, SCSqliteINListMarker];
+        result = [_dbHelper performWrite:^(SCSqliteDB *db) {
+            result = [self performTransactionOnDB:db block:^BOOL{
+                NSError *error = nil;
+                if (![db executeUpdate:sql parameters:nil inList:identifiers error:&error]) {
+                    [Logger error:@"Error deleting records: %@", [error localizedDescription]];
+                    return NO;
+                }
+                return YES;
+            }];
+        }] && result;
+        [self didWriteIDs:identifiers toTable:table succeeded:result];
         [self didChangeValueForKey:table];
     }
     return result;
 }
 
 - (BOOL)deleteID:(NSString *)recordID fromTable:(NSString *)table {
-    BOOL result = YES;
+    __block BOOL result = YES;
     NSString *idColumn = [self getColumnWithTag:@"id" fromTable:table];
     if (idColumn) {
-        SCSqliteDB *db = [_dbHelper getDatabase];
         NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@=?", table, idColumn];
         NSArray *params = @[ recordID ];
-        NSError *error = nil;
-        [db executeUpdate:sql parameters:params error:&error];
-        if (error) {
-            [Logger error:@"Error deleting records: %@", [error localizedDescription]];
-            result = NO;
-        }
+        result = [_dbHelper performWrite:^(SCSqliteDB *db) {
+            NSError *error = nil;
+            if (![db executeUpdate:sql parameters:params error:&error]) {
+                [Logger error:@"Error deleting records: %@", [error localizedDescription]];
+                result = NO;
+            }
+        }] && result;
+        [self didWriteIDs:params toTable:table succeeded:result];
     }
     return result;
 }
 
 - (BOOL)deleteFromTable:(NSString *)table where:(NSString *)where {
-    SCSqliteDB *db = [_dbHelper getDatabase];
     NSString *sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@", table, where];
-    BOOL ok = YES;
-    NSError *error = nil;
-    [db executeUpdate:sql parameters:nil error:&error];
-    if (error) {
-        [Logger error:@"Error deleting from table: %@", [error localizedDescription]];
-        ok = NO;
-    }
+    __block BOOL ok = YES;
+    ok = [_dbHelper performWrite:^(SCSqliteDB *db) {
+        NSError *error = nil;
+        if (![db executeUpdate:sql parameters:nil error:&error]) {
+            [Logger error:@"Error deleting from table: %@", [error localizedDescription]];
+            ok = NO;
+        }
+    }] && ok;
+    [self didWriteIDs:nil toTable:table succeeded:ok];
     return ok;
 }
 
+- (void)createRecordCache {
+    NSMutableDictionary *tableSizes = [NSMutableDictionary new];
+    BOOL cached = NO;
+    for (NSString *table in _tables) {
+        if (![self getColumnWithTag:@"id" fromTable:table]) {
+            continue;
+        }
+        NSNumber *size = [_tables[table] getValueAsNumber:@"recordCacheSize"];
+        NSUInteger tableSize = size ? [size unsignedIntegerValue] : _recordCacheSize;
+        tableSizes[table] = [NSNumber numberWithUnsignedInteger:tableSize];
+        cached |= tableSize > 0;
+    }
+    _recordCache = cached ? [[SCDBRecordCache alloc] initWithTableSizes:tableSizes viewSize:_recordCacheSize] : nil;
+}
+
+- (void)didWriteValueList:(NSArray *)valueList toTable:(NSString *)table succeeded:(BOOL)succeeded {
+    NSMutableArray *identifiers = [[NSMutableArray alloc] initWithCapacity:[valueList count]];
+    NSString *idColumn = [self getColumnWithTag:@"id" fromTable:table];
+    BOOL identified = idColumn != nil;
+    for (NSDictionary *values in valueList) {
+        id identifier = idColumn ? values[idColumn] : nil;
+        if (identifier) {
+            [identifiers addObject:identifier];
+        }
+        else {
+            identified = NO;
+        }
+    }
+    // Values without an ID can only have inserted new records, which won't have been cached; but
+    // views depending on the table are still cleared.
+    [_recordCache removeRecordsWithIDs:identifiers fromTable:table];
+    if (succeeded) {
+        [self recordChangedIDs:(identified ? identifiers : nil) inTable:table];
+    }
+}
+
+- (void)didWriteIDs:(NSArray *)identifiers toTable:(NSString *)table succeeded:(BOOL)succeeded {
+    if (identifiers) {
+        [_recordCache removeRecordsWithIDs:identifiers fromTable:table];
+    }
+    else {
+        [_recordCache clearTable:table];
+    }
+    if (succeeded) {
+        [self recordChangedIDs:identifiers inTable:table];
+    }
+}
+
+- (id)addChangeObserverForTables:(NSArray *)tables usingBlock:(SCDBChangeBlock)block {
+    SCDBChangeObserver *observer = [SCDBChangeObserver new];
+    observer.tables = tables ? [NSSet setWithArray:tables] : nil;
+    observer.block = block;
+    @synchronized (_changeObservers) {
+        [_changeObservers addObject:observer];
+    }
+    return observer;
+}
+
+- (void)removeChangeObserver:(id)observer {
+    @synchronized (_changeObservers) {
+        [_changeObservers removeObjectIdenticalTo:observer];
+    }
+}
+
+- (void)recordChangedIDs:(NSArray *)identifiers inTable:(NSString *)table {
+    @synchronized (_changeObservers) {
+        if ([_changeObservers count] == 0) {
+            return;
+        }
+        if (_transactionOpen) {
+            if (!_transactionChanges) {
+                _transactionChanges = [SCDBChangeSet new];
+            }
+            [_transactionChanges addIdentifiers:identifiers forTable:table];
+            return;
+        }
+        if (!_pendingChanges) {
+            _pendingChanges = [SCDBChangeSet new];
+        }
+        [_pendingChanges addIdentifiers:identifiers forTable:table];
+        [self scheduleChangeDelivery];
+    }
+}
+
+- (void)scheduleChangeDelivery {
+    if (_changeDeliveryScheduled || !_pendingChanges) {
+        return;
+    }
+    _changeDeliveryScheduled = YES;
+    // All changes recorded before the block runs are delivered together.
+    dispatch_queue_t queue = _asyncResultQueue ?: dispatch_get_main_queue();
+    dispatch_async(queue, ^{
+        [self deliverChanges];
+    });
+}
+
+- (void)deliverChanges {
+    SCDBChangeSet *changes;
+    NSArray *observers;
+    @synchronized (_changeObservers) {
+        changes = _pendingChanges;
+        _pendingChanges = nil;
+        _changeDeliveryScheduled = NO;
+        observers = [_changeObservers copy];
+    }
+    if ([changes isEmpty]) {
+        return;
+    }
+    for (SCDBChangeObserver *observer in observers) {
+        if (!observer.tables || [changes includesAnyTable:observer.tables]) {
+            observer.block(changes);
+        }
+    }
+}
+
+- (void)endTransactionChangesCommitted:(BOOL)committed {
+    @synchronized (_changeObservers) {
+        SCDBChangeSet *changes = _transactionChanges;
+        _transactionChanges = nil;
+        _transactionOpen = NO;
+        // Changes made within a rolled back transaction never reached the database.
+        if (committed && changes && ![changes isEmpty]) {
+            if (!_pendingChanges) {
+                _pendingChanges = changes;
+            }
+            else {
+                [_pendingChanges addChangeSet:changes];
+            }
+            [self scheduleChangeDelivery];
+        }
+    }
+}
+
 - (NSDictionary *)filterValues:(NSDictionary *)values forTable:(NSString *)table {
     NSMutableDictionary *result = [[NSMutableDictionary alloc] init];
     NSSet *columnNames = [_tableColumnNames objectForKey:table];
@@ -488,6 +1241,120 @@ static SCLogger *Logger;
     return result;
 }
 
+- (QPromise *)performReadAsync:(SCDBAsyncBlock)block {
+    return [self performAsync:block write:NO];
+}
+
+- (QPromise *)performWriteAsync:(SCDBAsyncBlock)block {
+    return [self performAsync:block write:YES];
+}
+
+- (QPromise *)performQueryAsync:(NSString *)sql withParams:(NSArray *)params {
+    return [self performReadAsync:^id(NSError **error) {
+        return [self performQuery:sql withParams:params];
+    }];
+}
+
+- (QPromise *)insertValueListAsync:(NSArray *)valueList intoTable:(NSString *)table {
+    dispatch_queue_t resultQueue = _asyncResultQueue ?: dispatch_get_main_queue();
+    return [self performAsyncOperation:^id(SCDBAsyncOperation *operation, SCSqliteDB *db, NSError **error) {
+        // Insert in chunks, checking for cancellation between chunks; a cancelled insert is rolled back.
+        NSUInteger count = [valueList count];
+        NSUInteger chunkSize = MAX(self.bulkInsertRowLimit, 1);
+        BOOL ok = [self performTransactionOnDB:db block:^BOOL{
+            for (NSUInteger start = 0; start < count; start += chunkSize) {
+                if (operation.cancelled) {
+                    return NO;
+                }
+                NSArray *chunk = [valueList subarrayWithRange:NSMakeRange(start, MIN(chunkSize, count - start))];
+                if (![self insertValueList:chunk intoTable:table db:db]) {
+                    return NO;
+                }
+            }
+            return YES;
+        }];
+        if (!ok) {
+            *error = [NSError errorWithDomain:SCDBErrorDomain
+                                         code:SCDBErrorFailed
+                                     userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Insert into %@ failed", table] }];
+            return nil;
+        }
+        [self didWriteValueList:valueList toTable:table succeeded:YES];
+        // Notify observers of the table on the result queue, before the promise is resolved.
+        dispatch_async(resultQueue, ^{
+            [self willChangeValueForKey:table];
+            [self didChangeValueForKey:table];
+        });
+        return @YES;
+    } write:YES];
+}
+
+- (void)cancelAsync:(QPromise *)promise {
+    SCDBAsyncOperation *operation;
+    @synchronized (_asyncOperations) {
+        operation = [_asyncOperations objectForKey:promise];
+    }
+    @synchronized (operation) {
+        operation.cancelled = YES;
+        [operation.db interrupt];
+    }
+}
+
+- (QPromise *)performAsync:(SCDBAsyncBlock)block write:(BOOL)write {
+    return [self performAsyncOperation:^id(SCDBAsyncOperation *operation, SCSqliteDB *db, NSError **error) {
+        return block(error);
+    } write:write];
+}
+
+- (QPromise *)performAsyncOperation:(SCDBAsyncOperationBlock)block write:(BOOL)write {
+    QPromise *promise = [QPromise new];
+    SCDBAsyncOperation *operation = [SCDBAsyncOperation new];
+    @synchronized (_asyncOperations) {
+        [_asyncOperations setObject:operation forKey:promise];
+    }
+    dispatch_queue_t resultQueue = _asyncResultQueue ?: dispatch_get_main_queue();
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        __block id result = nil;
+        __block NSError *error = nil;
+        SCDBHelperConnectionBlock connectionBlock = ^(SCSqliteDB *db) {
+            @synchronized (operation) {
+                if (operation.cancelled) {
+                    return;
+                }
+                // Record the connection so that the operation can be interrupted.
+                operation.db = db;
+            }
+            result = block(operation, db, &error);
+            @synchronized (operation) {
+                operation.db = nil;
+            }
+        };
+        BOOL ok = write ? [_dbHelper performWrite:connectionBlock] : [_dbHelper performRead:connectionBlock];
+        if (!ok && !error) {
+            error = [NSError errorWithDomain:SCDBErrorDomain
+                                        code:SCDBErrorFailed
+                                    userInfo:@{ NSLocalizedDescriptionKey: @"Unable to open database connection" }];
+        }
+        @synchronized (_asyncOperations) {
+            [_asyncOperations removeObjectForKey:promise];
+        }
+        if (operation.cancelled) {
+            error = [NSError errorWithDomain:SCDBErrorDomain
+                                        code:SCDBErrorCancelled
+                                    userInfo:@{ NSLocalizedDescriptionKey: @"Operation cancelled" }];
+        }
+        dispatch_async(resultQueue, ^{
+            if (error) {
+                [promise reject:error];
+            }
+            else {
+                [promise resolve:result];
+            }
+        });
+    });
+    return promise;
+}
+
 - (SCDB *)newInstance {
     SCDB *newDB = [[SCDB alloc] initWithDB:self];
     [newDB startService];
@@ -500,10 +1367,14 @@ static SCLogger *Logger;
     for (NSString *tableName in [_tables allKeys]) {
         NSDictionary *tableSchema = [_tables objectForKey:tableName];
         NSString *sql = [self getCreateTableSQLForTable:tableName schema:tableSchema];
-        [db executeUpdate:sql parameters:nil error:error];
-        if (*error) {
+        if (![db executeUpdate:sql parameters:nil error:error]) {
             return;
         }
+        for (NSString *sql in [self getCreateIndexSQLForTable:tableName schema:tableSchema version:[_version integerValue]]) {
+            if (![db executeUpdate:sql parameters:nil error:error]) {
+                return;
+            }
+        }
         [self addInitialDataForTable:tableName schema:tableSchema];
     }
     [self dbInitialize:db error:error];
@@ -517,16 +1388,31 @@ static SCLogger *Logger;
         NSInteger since = [[tableSchema getValueAsNumber:@"since" defaultValue:@0] integerValue];
         NSInteger until = [[tableSchema getValueAsNumber:@"until" defaultValue:_newVersion] integerValue];
         NSArray *sqls = nil;
+        if (_searchTableColumns[tableName]) {
+            // Drop the table's search table and triggers; they are recreated with the current search
+            // columns, and rebuilt, once migration has completed.
+            NSString *ftsTable = [self searchTableNameForTable:tableName];
+            for (NSString *sql in @[
+                [NSString stringWithFormat:@"DROP TRIGGER IF EXISTS %@_insert", ftsTable],
+                [NSString stringWithFormat:@"DROP TRIGGER IF EXISTS %@_delete", ftsTable],
+                [NSString stringWithFormat:@"DROP TRIGGER IF EXISTS %@_update", ftsTable],
+                [NSString stringWithFormat:@"DROP TABLE IF EXISTS %@", ftsTable]]) {
+                if (![database executeUpdate:sql parameters:nil error:error]) {
+                    return;
+                }
+            }
+        }
         if (since < (NSInteger)oldVersion) {
             // Table exists since before the current DB version, so should exist in the current DB.
             if (until < (NSInteger)newVersion) {
                 // Table not required in DB version being migrated to, so drop from database.
-                NSString *sql = [NSString stringWithFormat:@"DROP TABLE %@ IF EXISTS", tableName];
+                NSString *sql = [NSString stringWithFormat:@"DROP TABLE IF EXISTS %@", tableName];
                 sqls = [NSArray arrayWithObject:sql];
             }
             else {
                 // Modify table.
                 sqls = [self getAlterTableSQLForTable:tableName schema:tableSchema from:oldVersion to:newVersion];
+                sqls = [sqls arrayByAddingObjectsFromArray:[self getAlterIndexSQLForTable:tableName schema:tableSchema from:oldVersion to:newVersion]];
             }
         }
         else {
@@ -539,12 +1425,12 @@ static SCLogger *Logger;
             else {
                 // Create table.
                 sqls = [NSArray arrayWithObject:[self getCreateTableSQLForTable:tableName schema:tableSchema]];
+                sqls = [sqls arrayByAddingObjectsFromArray:[self getCreateIndexSQLForTable:tableName schema:tableSchema version:newVersion]];
                 [self addInitialDataForTable:tableName schema:tableSchema];
             }
         }
         for (NSString *sql in sqls) {
-            [database executeUpdate:sql parameters:nil error:error];
-            if (*error) {
+            if (![database executeUpdate:sql parameters:nil error:error]) {
                 return;
             }
         }
@@ -557,13 +1443,21 @@ static SCLogger *Logger;
 - (void)dbInitialize:(SCSqliteDB *)db error:(NSError *__autoreleasing *)error {
     [Logger info:@"Initializing database..."];
     for (NSString *tableName in [_initialData allKeys]) {
-        NSArray *data = [_initialData objectForKey:tableName];
-        for (NSDictionary *values in data) {
-            [self insertValues:values intoTable:tableName db:db];
+        id data = [_initialData objectForKey:tableName];
+        if ([data isKindOfClass:[SCDBDataLoader class]]) {
+            if (![self loadInitialDataForTable:tableName withLoader:data db:db error:error]) {
+                return;
+            }
+        }
+        else if (![self insertValueList:data intoTable:tableName db:db]) {
+            *error = [NSError errorWithDomain:SCDBErrorDomain
+                                         code:SCDBErrorFailed
+                                     userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Error inserting %@ data", tableName] }];
+            return;
         }
         NSString *sql = [NSString stringWithFormat:@"select count() from %@", tableName];
         SCSqliteResultSet *rs = [db executeQuery:sql error:error];
-        if (*error) {
+        if (!rs) {
             return;
         }
         if ([rs next]) {
@@ -581,6 +1475,74 @@ static SCLogger *Logger;
     if ([data isKindOfClass:[NSArray class]]) {
         [_initialData setObject:data forKey:tableName];
     }
+    else if (data) {
+        // Data is in a file, which is streamed into the table when the database is initialized.
+        NSString *path = nil;
+        if ([data isKindOfClass:[SCResource class]]) {
+            path = [(SCResource *)data asRepresentationType:SCRepresentationFilePath];
+        }
+        else if ([data isKindOfClass:[NSString class]]) {
+            path = [self initialDataPathForString:data];
+        }
+        if (path) {
+            NSString *format = [tableSchema getValueAsString:@"dataFormat"];
+            [_initialData setObject:[[SCDBDataLoader alloc] initWithPath:path format:format] forKey:tableName];
+        }
+        else {
+            [Logger warn:@"Unable to resolve data file for table %@", tableName];
+        }
+    }
+}
+
+- (BOOL)loadInitialDataForTable:(NSString *)tableName withLoader:(SCDBDataLoader *)loader db:(SCSqliteDB *)db error:(NSError **)error {
+    [Logger info:@"Loading %@ data from %@", tableName, loader.path];
+    // Records are inserted in batches using multi-row statements, which are reused from the
+    // statement cache; the migration's transaction is joined.
+    NSMutableArray *batch = [[NSMutableArray alloc] initWithCapacity:InitialDataBatchSize];
+    __block NSUInteger rowCount = 0;
+    __block BOOL inserted = YES;
+    SCDBInitialDataProgressBlock progress = _initialDataProgressBlock;
+    BOOL (^insertBatch)(void) = ^BOOL{
+        BOOL ok = [self insertValueList:batch intoTable:tableName db:db];
+        rowCount += [batch count];
+        [batch removeAllObjects];
+        if (ok && progress) {
+            progress(tableName, rowCount);
+        }
+        return ok;
+    };
+    BOOL ok = [loader readRecords:^(NSDictionary *record, BOOL *stop) {
+        [batch addObject:record];
+        if ([batch count] == InitialDataBatchSize) {
+            inserted = insertBatch();
+            *stop = !inserted;
+        }
+    } error:error];
+    if (ok && inserted && [batch count] > 0) {
+        inserted = insertBatch();
+    }
+    if (!ok) {
+        [Logger error:@"Error reading %@ data: %@", tableName, [*error localizedDescription]];
+    }
+    else if (!inserted) {
+        // Fail the migration, so that its transaction is rolled back rather than committed with partial data.
+        NSString *message = [NSString stringWithFormat:@"Error inserting %@ data, loading stopped after %lu rows", tableName, (unsigned long)rowCount];
+        [Logger error:@"%@", message];
+        *error = [NSError errorWithDomain:SCDBErrorDomain
+                                     code:SCDBErrorFailed
+                                 userInfo:@{ NSLocalizedDescriptionKey: message }];
+    }
+    return ok && inserted;
+}
+
+- (NSString *)initialDataPathForString:(NSString *)data {
+    if ([data hasPrefix:@"file:"]) {
+        return [[NSURL URLWithString:data] path];
+    }
+    if ([data isAbsolutePath]) {
+        return data;
+    }
+    return [[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:data];
 }
 
 - (NSString *)getCreateTableSQLForTable:(NSString *)tableName schema:(NSDictionary *)tableSchema {
@@ -618,4 +1580,67 @@ static SCLogger *Logger;
     return sqls;
 }
 
+- (NSArray *)getCreateIndexSQLForTable:(NSString *)tableName schema:(NSDictionary *)tableSchema version:(NSInteger)version {
+    NSNumber *_version = [NSNumber numberWithInteger:version];
+    NSMutableArray *sqls = [[NSMutableArray alloc] init];
+    NSDictionary *indexes = [tableSchema valueForKey:@"indexes"];
+    for (NSString *indexName in [indexes allKeys]) {
+        NSDictionary *indexSchema = [indexes objectForKey:indexName];
+        NSInteger until = [[indexSchema getValueAsNumber:@"until" defaultValue:_version] integerValue];
+        // Create all indexes not disabled before the current version.
+        if (!(until < version)) {
+            NSString *sql = [self getCreateIndexSQLForIndex:indexName table:tableName schema:indexSchema];
+            if (sql) {
+                [sqls addObject:sql];
+            }
+        }
+    }
+    return sqls;
+}
+
+- (NSArray *)getAlterIndexSQLForTable:(NSString *)tableName schema:(NSDictionary *)tableSchema from:(NSInteger)oldVersion to:(NSInteger)newVersion {
+    NSNumber *_newVersion = [NSNumber numberWithInteger:newVersion];
+    NSMutableArray *sqls = [[NSMutableArray alloc] init];
+    NSDictionary *indexes = [tableSchema valueForKey:@"indexes"];
+    for (NSString *indexName in [indexes allKeys]) {
+        NSDictionary *indexSchema = [indexes objectForKey:indexName];
+        NSInteger since = [[indexSchema getValueAsNumber:@"since" defaultValue:@0] integerValue];
+        NSInteger until = [[indexSchema getValueAsNumber:@"until" defaultValue:_newVersion] integerValue];
+        if (until < newVersion) {
+            // Index not required in the version being migrated to, so drop it if it exists.
+            if (!(until < oldVersion)) {
+                [sqls addObject:[NSString stringWithFormat:@"DROP INDEX IF EXISTS %@", indexName]];
+            }
+        }
+        else if (since > oldVersion) {
+            // Index added since the current db version.
+            NSString *sql = [self getCreateIndexSQLForIndex:indexName table:tableName schema:indexSchema];
+            if (sql) {
+                [sqls addObject:sql];
+            }
+        }
+    }
+    return sqls;
+}
+
+- (NSString *)getCreateIndexSQLForIndex:(NSString *)indexName table:(NSString *)tableName schema:(NSDictionary *)indexSchema {
+    id columns = [indexSchema valueForKey:@"columns"];
+    if ([columns isKindOfClass:[NSArray class]]) {
+        columns = [(NSArray *)columns componentsJoinedByString:@","];
+    }
+    if (![columns isKindOfClass:[NSString class]] || [columns length] == 0) {
+        [Logger warn:@"No columns specified for index %@ on table %@", indexName, tableName];
+        return nil;
+    }
+    BOOL unique = [indexSchema getValueAsBoolean:@"unique" defaultValue:NO];
+    NSString *where = [indexSchema getValueAsString:@"where"];
+    NSMutableString *sql = [[NSMutableString alloc] init];
+    [sql appendString:(unique ? @"CREATE UNIQUE INDEX" : @"CREATE INDEX")];
+    [sql appendFormat:@" IF NOT EXISTS %@ ON %@ (%@)", indexName, tableName, columns];
+    if (where) {
+        [sql appendFormat:@" WHERE %@", where];
+    }
+    return sql;
+}
+
 @end
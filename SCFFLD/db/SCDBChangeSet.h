@@ -0,0 +1,53 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A set of changes made to a database's tables.
+ * Lists the IDs of the rows written to each changed table - inserted, updated or deleted. Where
+ * the rows written to a table aren't known, e.g. after an insert of a record without an ID or a
+ * raw SQL update, the whole table should be treated as changed.
+ */
+@interface SCDBChangeSet : NSObject {
+    /// The IDs of the rows written to each table, keyed by table name; NSNull where the rows aren't known.
+    NSMutableDictionary *_tableIdentifiers;
+}
+
+/// The names of the changed tables.
+@property (nonatomic, readonly) NSSet *tables;
+/// Test whether the change set is empty.
+@property (nonatomic, readonly) BOOL isEmpty;
+
+/// Test whether a table has changed.
+- (BOOL)includesTable:(NSString *)table;
+/// Test whether any of the named tables have changed.
+- (BOOL)includesAnyTable:(NSSet *)tables;
+/**
+ * Return the IDs of the rows written to a table.
+ * Returns _nil_ if the table hasn't changed, or if the rows written aren't known.
+ */
+- (NSSet *)identifiersForTable:(NSString *)table;
+/**
+ * Add the IDs of rows written to a table.
+ * Pass _nil_ identifiers if the rows written aren't known.
+ */
+- (void)addIdentifiers:(NSArray *)identifiers forTable:(NSString *)table;
+/// Add the changes in another change set.
+- (void)addChangeSet:(SCDBChangeSet *)changeSet;
+
+@end
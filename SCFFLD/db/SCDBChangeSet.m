@@ -0,0 +1,84 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCDBChangeSet.h"
+
+@implementation SCDBChangeSet
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _tableIdentifiers = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (NSSet *)tables {
+    return [NSSet setWithArray:[_tableIdentifiers allKeys]];
+}
+
+- (BOOL)isEmpty {
+    return [_tableIdentifiers count] == 0;
+}
+
+- (BOOL)includesTable:(NSString *)table {
+    return _tableIdentifiers[table] != nil;
+}
+
+- (BOOL)includesAnyTable:(NSSet *)tables {
+    for (NSString *table in tables) {
+        if (_tableIdentifiers[table]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (NSSet *)identifiersForTable:(NSString *)table {
+    id identifiers = _tableIdentifiers[table];
+    return identifiers == [NSNull null] ? nil : identifiers;
+}
+
+- (void)addIdentifiers:(NSArray *)identifiers forTable:(NSString *)table {
+    id current = _tableIdentifiers[table];
+    if (current == [NSNull null]) {
+        // All of the table's rows are already marked as changed.
+        return;
+    }
+    if (!identifiers) {
+        _tableIdentifiers[table] = [NSNull null];
+    }
+    else if (current) {
+        [(NSMutableSet *)current addObjectsFromArray:identifiers];
+    }
+    else {
+        _tableIdentifiers[table] = [NSMutableSet setWithArray:identifiers];
+    }
+}
+
+- (void)addChangeSet:(SCDBChangeSet *)changeSet {
+    for (NSString *table in changeSet->_tableIdentifiers) {
+        id identifiers = changeSet->_tableIdentifiers[table];
+        [self addIdentifiers:(identifiers == [NSNull null] ? nil : [identifiers allObjects]) forTable:table];
+    }
+}
+
+- (NSString *)description {
+    return [_tableIdentifiers description];
+}
+
+@end
@@ -0,0 +1,80 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/// JSON data: a single array of records.
+#define SCDBDataLoaderFormatJSON    (@"json")
+/// Newline delimited JSON data: one record per line.
+#define SCDBDataLoaderFormatNDJSON  (@"ndjson")
+/// CSV data: a header row of column names, followed by one record per row.
+#define SCDBDataLoaderFormatCSV     (@"csv")
+
+/**
+ * A block for receiving records read from a data file.
+ * Set _stop_ to YES to stop reading.
+ */
+typedef void (^SCDBDataLoaderRecordBlock) (NSDictionary *record, BOOL *stop);
+
+/**
+ * A streaming reader of table data files.
+ * Reads records from a JSON, NDJSON or CSV file in fixed size chunks, so that only the record
+ * currently being read is held in memory. Used by SCDB to load a table's initial data.
+ */
+@interface SCDBDataLoader : NSObject {
+    /// A buffer of data read from the file but not yet consumed.
+    NSMutableData *_buffer;
+    /// The position in the buffer where scanning resumes.
+    NSUInteger _scanPosition;
+    /// The buffer position of the start of the current record; or -1 if not in a record.
+    NSInteger _recordStart;
+    /// JSON scanner state: the current nesting depth, and whether in a string or after an escape.
+    NSInteger _depth;
+    BOOL _inString;
+    BOOL _escaped;
+    /// CSV scanner state: the column names, the current row and field, and quote state.
+    NSArray *_csvColumns;
+    NSMutableArray *_csvRow;
+    NSMutableData *_csvField;
+    BOOL _inQuotes;
+    BOOL _quotePending;
+    BOOL _fieldQuoted;
+}
+
+/**
+ * Initialize a loader.
+ * @param path  The path to the data file.
+ * @param format The data format; or _nil_ to use the format indicated by the file extension.
+ */
+- (id)initWithPath:(NSString *)path format:(NSString *)format;
+
+/// The path to the data file.
+@property (nonatomic, strong, readonly) NSString *path;
+/// The data format.
+@property (nonatomic, strong, readonly) NSString *format;
+
+/**
+ * Read the file's records, passing each to a block as it is read.
+ * CSV values are read as strings, and empty unquoted values are omitted from records.
+ * @return YES if the file was read successfully; otherwise NO, with _error_ set.
+ */
+- (BOOL)readRecords:(SCDBDataLoaderRecordBlock)block error:(NSError **)error;
+
+/// Return the data format indicated by a file's extension; JSON is assumed for unknown extensions.
++ (NSString *)formatForPath:(NSString *)path;
+
+@end
@@ -0,0 +1,383 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCDBDataLoader.h"
+
+/// The number of bytes read from the file at a time.
+static const NSUInteger ChunkSize = 65536;
+
+@interface SCDBDataLoader ()
+
+/// Reset the scanner state before reading the file.
+- (void)resetScanner;
+/// Scan the buffered data for records. Returns NO if the data isn't valid.
+- (BOOL)scanAtEnd:(BOOL)atEnd block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error;
+- (BOOL)scanJSONAtEnd:(BOOL)atEnd block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error;
+- (BOOL)scanNDJSONAtEnd:(BOOL)atEnd block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error;
+- (BOOL)scanCSVAtEnd:(BOOL)atEnd block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error;
+/// Parse a JSON record from a range of the buffer and pass it to the record block.
+- (BOOL)readJSONRecordInRange:(NSRange)range block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error;
+/// End the current CSV field.
+- (void)endCSVField;
+/// End the current CSV row, and pass it to the record block if it isn't the header row.
+- (void)endCSVRowWithBlock:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop;
+/// Remove consumed data from the start of the buffer.
+- (void)compactBuffer:(NSUInteger)consumed;
+/// Return a data format error.
+- (NSError *)formatError:(NSString *)reason;
+
+@end
+
+@implementation SCDBDataLoader
+
+- (id)initWithPath:(NSString *)path format:(NSString *)format {
+    self = [super init];
+    if (self) {
+        _path = path;
+        _format = format ? [format lowercaseString] : [SCDBDataLoader formatForPath:path];
+    }
+    return self;
+}
+
+- (BOOL)readRecords:(SCDBDataLoaderRecordBlock)block error:(NSError **)error {
+    NSInputStream *stream = [NSInputStream inputStreamWithFileAtPath:_path];
+    [stream open];
+    if (!stream || [stream streamStatus] == NSStreamStatusError) {
+        if (error) {
+            *error = stream.streamError ?: [self formatError:@"File can't be opened"];
+        }
+        return NO;
+    }
+    [self resetScanner];
+    uint8_t *chunk = malloc(ChunkSize);
+    BOOL ok = YES, stop = NO, atStart = YES;
+    NSError *scanError = nil;
+    while (ok && !stop) {
+        NSInteger length = [stream read:chunk maxLength:ChunkSize];
+        if (length < 0) {
+            scanError = stream.streamError;
+            ok = NO;
+            break;
+        }
+        BOOL atEnd = (length == 0);
+        [_buffer appendBytes:chunk length:length];
+        if (atStart && [_buffer length] >= 3) {
+            // Skip any UTF-8 byte order mark.
+            const uint8_t *bytes = [_buffer bytes];
+            if (bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+                [self compactBuffer:3];
+            }
+            atStart = NO;
+        }
+        @autoreleasepool {
+            ok = [self scanAtEnd:atEnd block:block stop:&stop error:&scanError];
+        }
+        if (atEnd) {
+            break;
+        }
+    }
+    free(chunk);
+    [stream close];
+    // Release scanner state.
+    _buffer = nil;
+    _csvColumns = nil;
+    _csvRow = nil;
+    _csvField = nil;
+    if (!ok && error) {
+        *error = scanError;
+    }
+    return ok;
+}
+
++ (NSString *)formatForPath:(NSString *)path {
+    NSString *ext = [[path pathExtension] lowercaseString];
+    if ([ext isEqualToString:@"ndjson"] || [ext isEqualToString:@"jsonl"]) {
+        return SCDBDataLoaderFormatNDJSON;
+    }
+    if ([ext isEqualToString:@"csv"]) {
+        return SCDBDataLoaderFormatCSV;
+    }
+    return SCDBDataLoaderFormatJSON;
+}
+
+#pragma mark - Private methods
+
+- (void)resetScanner {
+    _buffer = [NSMutableData new];
+    _scanPosition = 0;
+    // For JSON, the start of the current array item; for NDJSON, the start of the current line.
+    _recordStart = [SCDBDataLoaderFormatNDJSON isEqualToString:_format] ? 0 : -1;
+    _depth = 0;
+    _inString = NO;
+    _escaped = NO;
+    _csvColumns = nil;
+    _csvRow = [NSMutableArray new];
+    _csvField = [NSMutableData new];
+    _inQuotes = NO;
+    _quotePending = NO;
+    _fieldQuoted = NO;
+}
+
+- (BOOL)scanAtEnd:(BOOL)atEnd block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error {
+    if ([SCDBDataLoaderFormatNDJSON isEqualToString:_format]) {
+        return [self scanNDJSONAtEnd:atEnd block:block stop:stop error:error];
+    }
+    if ([SCDBDataLoaderFormatCSV isEqualToString:_format]) {
+        return [self scanCSVAtEnd:atEnd block:block stop:stop error:error];
+    }
+    return [self scanJSONAtEnd:atEnd block:block stop:stop error:error];
+}
+
+- (BOOL)scanJSONAtEnd:(BOOL)atEnd block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error {
+    // Find the extent of each item of the top-level array, by tracking nesting depth and strings;
+    // a depth of -1 indicates that the end of the array has been read.
+    const uint8_t *bytes = [_buffer bytes];
+    NSUInteger length = [_buffer length];
+    NSUInteger i = _scanPosition;
+    for (; i < length && _depth >= 0 && !*stop; i++) {
+        uint8_t b = bytes[i];
+        if (_inString) {
+            if (_escaped) {
+                _escaped = NO;
+            }
+            else if (b == '\\') {
+                _escaped = YES;
+            }
+            else if (b == '"') {
+                _inString = NO;
+            }
+            continue;
+        }
+        if (b == ' ' || b == '\t' || b == '\r' || b == '\n') {
+            continue;
+        }
+        if (_depth == 0) {
+            if (b != '[') {
+                *error = [self formatError:@"JSON data isn't an array"];
+                return NO;
+            }
+            _depth = 1;
+            continue;
+        }
+        switch (b) {
+        case '"':
+            _inString = YES;
+            if (_depth == 1 && _recordStart < 0) {
+                _recordStart = i;
+            }
+            break;
+        case '{':
+        case '[':
+            if (_depth == 1 && _recordStart < 0) {
+                _recordStart = i;
+            }
+            _depth++;
+            break;
+        case '}':
+        case ']':
+            _depth--;
+            if (_depth == 1 && _recordStart >= 0) {
+                if (![self readJSONRecordInRange:NSMakeRange(_recordStart, i + 1 - _recordStart) block:block stop:stop error:error]) {
+                    return NO;
+                }
+                _recordStart = -1;
+            }
+            else if (_depth == 0) {
+                // End of the array.
+                _recordStart = -1;
+                _depth = -1;
+            }
+            break;
+        case ',':
+            if (_depth == 1 && _recordStart >= 0) {
+                // End of a non-object array item, which is ignored.
+                _recordStart = -1;
+            }
+            break;
+        default:
+            if (_depth == 1 && _recordStart < 0) {
+                _recordStart = i;
+            }
+        }
+    }
+    if (atEnd && !*stop && _depth > 0) {
+        *error = [self formatError:@"Unexpected end of JSON data"];
+        return NO;
+    }
+    _scanPosition = i;
+    [self compactBuffer:(_recordStart >= 0 ? _recordStart : i)];
+    return YES;
+}
+
+- (BOOL)scanNDJSONAtEnd:(BOOL)atEnd block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error {
+    const uint8_t *bytes = [_buffer bytes];
+    NSUInteger length = [_buffer length];
+    NSUInteger i = _scanPosition;
+    for (; i < length && !*stop; i++) {
+        if (bytes[i] == '\n') {
+            if (![self readJSONRecordInRange:NSMakeRange(_recordStart, i - _recordStart) block:block stop:stop error:error]) {
+                return NO;
+            }
+            _recordStart = i + 1;
+        }
+    }
+    if (atEnd && !*stop && (NSUInteger)_recordStart < length) {
+        // Read the final line, which has no line terminator.
+        if (![self readJSONRecordInRange:NSMakeRange(_recordStart, length - _recordStart) block:block stop:stop error:error]) {
+            return NO;
+        }
+        _recordStart = length;
+    }
+    _scanPosition = i;
+    [self compactBuffer:_recordStart];
+    return YES;
+}
+
+- (BOOL)scanCSVAtEnd:(BOOL)atEnd block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error {
+    const uint8_t *bytes = [_buffer bytes];
+    NSUInteger length = [_buffer length];
+    NSUInteger i = _scanPosition;
+    for (; i < length && !*stop; i++) {
+        uint8_t b = bytes[i];
+        if (_quotePending) {
+            // A quote within a quoted field; a second quote is an escaped quote, anything else ends the quoted text.
+            _quotePending = NO;
+            if (b == '"') {
+                [_csvField appendBytes:&b length:1];
+                _inQuotes = YES;
+                continue;
+            }
+        }
+        if (_inQuotes) {
+            if (b == '"') {
+                _inQuotes = NO;
+                _quotePending = YES;
+            }
+            else {
+                [_csvField appendBytes:&b length:1];
+            }
+            continue;
+        }
+        switch (b) {
+        case '"':
+            if ([_csvField length] == 0 && !_fieldQuoted) {
+                _inQuotes = YES;
+                _fieldQuoted = YES;
+            }
+            else {
+                [_csvField appendBytes:&b length:1];
+            }
+            break;
+        case ',':
+            [self endCSVField];
+            break;
+        case '\n':
+            [self endCSVField];
+            [self endCSVRowWithBlock:block stop:stop];
+            break;
+        case '\r':
+            break;
+        default:
+            [_csvField appendBytes:&b length:1];
+        }
+    }
+    if (atEnd && !*stop && ([_csvField length] > 0 || _fieldQuoted || [_csvRow count] > 0)) {
+        // Read the final row, which has no line terminator.
+        [self endCSVField];
+        [self endCSVRowWithBlock:block stop:stop];
+    }
+    _scanPosition = i;
+    [self compactBuffer:i];
+    return YES;
+}
+
+- (BOOL)readJSONRecordInRange:(NSRange)range block:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop error:(NSError **)error {
+    const uint8_t *bytes = (const uint8_t *)[_buffer bytes] + range.location;
+    // Skip blank lines.
+    BOOL blank = YES;
+    for (NSUInteger i = 0; i < range.length && blank; i++) {
+        blank = (bytes[i] == ' ' || bytes[i] == '\t' || bytes[i] == '\r');
+    }
+    if (blank) {
+        return YES;
+    }
+    NSData *data = [NSData dataWithBytesNoCopy:(void *)bytes length:range.length freeWhenDone:NO];
+    id record = [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+    if (!record) {
+        return NO;
+    }
+    if ([record isKindOfClass:[NSDictionary class]]) {
+        block(record, stop);
+    }
+    return YES;
+}
+
+- (void)endCSVField {
+    if ([_csvField length] == 0 && !_fieldQuoted) {
+        [_csvRow addObject:[NSNull null]];
+    }
+    else {
+        NSString *value = [[NSString alloc] initWithData:_csvField encoding:NSUTF8StringEncoding];
+        [_csvRow addObject:(value ?: @"")];
+    }
+    [_csvField setLength:0];
+    _fieldQuoted = NO;
+}
+
+- (void)endCSVRowWithBlock:(SCDBDataLoaderRecordBlock)block stop:(BOOL *)stop {
+    NSArray *row = _csvRow;
+    _csvRow = [NSMutableArray new];
+    if ([row count] == 1 && row[0] == [NSNull null]) {
+        // Blank line.
+        return;
+    }
+    if (!_csvColumns) {
+        // First row contains the column names.
+        _csvColumns = row;
+        return;
+    }
+    NSMutableDictionary *record = [NSMutableDictionary new];
+    NSUInteger count = MIN([row count], [_csvColumns count]);
+    for (NSUInteger i = 0; i < count; i++) {
+        id column = _csvColumns[i];
+        id value = row[i];
+        if (value != [NSNull null] && column != [NSNull null]) {
+            record[column] = value;
+        }
+    }
+    block(record, stop);
+}
+
+- (void)compactBuffer:(NSUInteger)consumed {
+    if (consumed == 0) {
+        return;
+    }
+    [_buffer replaceBytesInRange:NSMakeRange(0, consumed) withBytes:NULL length:0];
+    _scanPosition -= MIN(consumed, _scanPosition);
+    if (_recordStart >= 0) {
+        _recordStart = (NSUInteger)_recordStart > consumed ? _recordStart - (NSInteger)consumed : 0;
+    }
+}
+
+- (NSError *)formatError:(NSString *)reason {
+    NSString *description = [NSString stringWithFormat:@"%@: %@", _path, reason];
+    return [NSError errorWithDomain:NSCocoaErrorDomain
+                               code:NSFileReadCorruptFileError
+                           userInfo:@{ NSLocalizedDescriptionKey: description }];
+}
+
+@end
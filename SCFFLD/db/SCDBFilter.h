@@ -18,17 +18,46 @@
 
 #import <Foundation/Foundation.h>
 #import "SCDB.h"
+#import "SCDBLiveQuery.h"
 
+/**
+ * A configurable database query.
+ * A filter is either configured with an SQL string, in which named parameters are written as _?name_;
+ * or with a table name, a dictionary of column filter values and an optional order by clause.
+ * The filter is compiled once, on first use, into SQL with positional parameters; all filter values
+ * are bound as statement parameters, so the compiled SQL is reused from the database's prepared
+ * statement cache on each application of the filter.
+ */
 @interface SCDBFilter : NSObject {
+    /// The name of the parameter bound to each positional parameter of the compiled SQL.
     NSArray *_paramNames;
+    /// The compiled SQL, split at each positional parameter.
+    NSArray *_sqlSegments;
+    /// Values configured in the filters dictionary, keyed by generated parameter name.
+    NSDictionary *_filterValues;
 }
 
+/// The filter SQL. Named parameters (_?name_) are replaced with positional parameters when set.
 @property (nonatomic, strong) NSString *sql;
 @property (nonatomic, strong) NSString *table;
 @property (nonatomic, strong) NSDictionary *filters;
 @property (nonatomic, strong) NSString *orderBy;
 @property (nonatomic, strong) NSString *predicateOp;
 
+/**
+ * Apply the filter to a database.
+ * A parameter value which is an array is expanded to a parenthesized list of positional parameters,
+ * so that it can be used with an IN operator, e.g. _id IN ?ids_. Lists are padded to a few sizes, so that
+ * statements are reused; see SCSqliteDB's INListSizeForCount:. Note that a list can't be longer than
+ * SQLite's parameter limit; use SCDB's enumerateQuery:params:inList:usingResultSetBlock: for longer lists.
+ */
 - (NSArray *)applyTo:(SCDB *)db withParameters:(NSDictionary *)params;
+/**
+ * Return a live query applying the filter to a database.
+ * The query is re-run when the filter's table, or the tables referenced by its SQL, change; when
+ * configured with a table, result rows are matched by the table's ID. The query must be started;
+ * see SCDBLiveQuery.
+ */
+- (SCDBLiveQuery *)liveQueryOn:(SCDB *)db withParameters:(NSDictionary *)params;
 
 @end
@@ -18,7 +18,20 @@
 
 #import "SCDBFilter.h"
 #import "SCRegExp.h"
-#import "NSString+SC.h"
+
+/// Append SQL text to a list of compiled SQL segments, starting a new segment at each named parameter.
+static void SCDBFilterAppendSQL(NSString *sql, NSMutableArray *segments, NSMutableArray *paramNames);
+/// Append a named parameter to a list of compiled SQL segments.
+static void SCDBFilterAppendParam(NSString *name, NSMutableArray *segments, NSMutableArray *paramNames);
+
+@interface SCDBFilter ()
+
+/// Compile the filter SQL from the table, filters and orderBy properties.
+- (void)compileFilters;
+/// Set the compiled SQL.
+- (void)setSqlSegments:(NSArray *)segments paramNames:(NSArray *)paramNames filterValues:(NSDictionary *)filterValues;
+
+@end
 
 @implementation SCDBFilter
 
@@ -31,87 +44,210 @@
 }
 
 - (void)setSql:(NSString *)sql {
-    // Extract parameter names from the SQL string. Parameter names appear as ?xxx in the SQL.
-    NSMutableArray *paramNames = [[NSMutableArray alloc] init];
-    SCRegExp *re = [[SCRegExp alloc] initWithPattern:@"\\?(\\w+)(.*)"];
-    NSArray *groups = [re match:sql];
-    while ([groups count]) {
-        [paramNames addObject:[groups objectAtIndex:1]];
-        groups = [re match:[groups objectAtIndex:2]];
+    if (!sql) {
+        [self setSqlSegments:nil paramNames:nil filterValues:nil];
+        return;
     }
+    // Split the SQL at each named parameter. Parameter names appear as ?xxx in the SQL.
+    NSMutableArray *segments = [[NSMutableArray alloc] initWithObjects:[NSMutableString new], nil];
+    NSMutableArray *paramNames = [NSMutableArray new];
+    SCDBFilterAppendSQL(sql, segments, paramNames);
+    [self setSqlSegments:segments paramNames:paramNames filterValues:nil];
+}
+
+- (void)setSqlSegments:(NSArray *)segments paramNames:(NSArray *)paramNames filterValues:(NSDictionary *)filterValues {
+    _sqlSegments = segments;
     _paramNames = paramNames;
+    _filterValues = filterValues;
     // Replace all argument placeholders with just '?' in the SQL.
-    _sql = [sql replaceAllOccurrences:@"\\?\\w+" with:@"?"];
+    _sql = segments ? [segments componentsJoinedByString:@"?"] : nil;
 }
 
-- (NSArray *)applyTo:(SCDB *)db withParameters:(NSDictionary *)params {
-    // Prepare the SQL. If the filter has been configured using table/filters/orderBy properties then
-    // _sql won't be set on first call.
-    if (!_sql && _table) {
-        NSMutableArray *terms = [[NSMutableArray alloc] init];
-        [terms addObject:@"SELECT * FROM"];
-        [terms addObject:_table];
-        if (_filters) {
-            [terms addObject:@"WHERE"];
-            // Regex pattern for detecting filter values that contain a predicate.
-            SCRegExp *predicatePattern = [[SCRegExp alloc] initWithPattern:@"^\\s*(=|<|>|LIKE\\s|NOT\\s)"];
-            BOOL insertPredicateOp = NO;
-            for (NSString *filterName in [_filters keyEnumerator]) {
-                if (insertPredicateOp) {
-                    [terms addObject:_predicateOp];
+- (void)compileFilters {
+    NSMutableArray *segments = [[NSMutableArray alloc] initWithObjects:[NSMutableString new], nil];
+    NSMutableArray *paramNames = [NSMutableArray new];
+    NSMutableDictionary *filterValues = [NSMutableDictionary new];
+    SCDBFilterAppendSQL([NSString stringWithFormat:@"SELECT * FROM %@", _table], segments, paramNames);
+    if ([_filters count]) {
+        SCDBFilterAppendSQL(@" WHERE ", segments, paramNames);
+        // Regex pattern for detecting filter values that contain a predicate.
+        SCRegExp *predicatePattern = [[SCRegExp alloc] initWithPattern:@"^\\s*(=|<|>|LIKE\\s|NOT\\s)"];
+        BOOL insertPredicateOp = NO;
+        for (NSString *filterName in [_filters keyEnumerator]) {
+            if (insertPredicateOp) {
+                SCDBFilterAppendSQL([NSString stringWithFormat:@" %@ ", _predicateOp], segments, paramNames);
+            }
+            SCDBFilterAppendSQL(filterName, segments, paramNames);
+            id filterValue = [_filters valueForKey:filterName];
+            if ([filterValue isKindOfClass:[NSArray class]]) {
+                // Use a WHERE ... IN (...) to query for an array of values. The array is bound as a single
+                // parameter, which applyTo: expands to a padded parameter list, or to (NULL) if it's empty.
+                NSString *name = [NSString stringWithFormat:@"#%@", filterName];
+                filterValues[name] = filterValue;
+                SCDBFilterAppendSQL(@" IN ", segments, paramNames);
+                SCDBFilterAppendParam(name, segments, paramNames);
+            }
+            else {
+                // Convert a non-string, non-number filter value to a string.
+                if (![filterValue isKindOfClass:[NSString class]] && ![filterValue isKindOfClass:[NSNumber class]]) {
+                    filterValue = [filterValue description];
                 }
-                [terms addObject:filterName];
-                id filterValue = [_filters valueForKey:filterName];
-                if ([filterValue isKindOfClass:[NSArray class]]) {
-                    // Use a WHERE ... IN (...) to query for an array of values.
-                    filterValue = [(NSArray *)filterValue componentsJoinedByString:@","];
-                    [terms addObject:[NSString stringWithFormat:@"IN (%@)", filterValue]];
+                if ([filterValue isKindOfClass:[NSString class]] && [predicatePattern matches:filterValue]) {
+                    SCDBFilterAppendSQL(@" ", segments, paramNames);
+                    SCDBFilterAppendSQL(filterValue, segments, paramNames);
+                }
+                else if ([filterValue isKindOfClass:[NSString class]] && [filterValue hasPrefix:@"?"]) {
+                    // ? prefix indicates a parameterized value.
+                    SCDBFilterAppendSQL(@" = ", segments, paramNames);
+                    SCDBFilterAppendSQL(filterValue, segments, paramNames);
                 }
                 else {
-                    // Convert a non-string filter value to a string.
-                    if (![filterValue isKindOfClass:[NSString class]]) {
-                        filterValue = [filterValue description];
-                    }
-                    if ([predicatePattern matches:filterValue]) {
-                        [terms addObject:filterValue];
-                    }
-                    else if ([filterValue hasPrefix:@"?"]) {
-                        // ? prefix indicates a parameterized value; don't quote in the SQL.
-                        [terms addObject:[NSString stringWithFormat:@"= %@", filterValue]];
-                    }
-                    else {
-                        // Escape single quotes in the value.
-                        filterValue = [filterValue replaceAllOccurrences:@"'" with:@"\\'"];
-                        [terms addObject:[NSString stringWithFormat:@"= '%@'", filterValue]];
-                    }
+                    // Bind the value as a parameter; generated names can't clash with SQL parameter names.
+                    NSString *name = [NSString stringWithFormat:@"#%@", filterName];
+                    filterValues[name] = filterValue;
+                    SCDBFilterAppendSQL(@" = ", segments, paramNames);
+                    SCDBFilterAppendParam(name, segments, paramNames);
                 }
-                insertPredicateOp = YES;
             }
+            insertPredicateOp = YES;
         }
-        if (_orderBy) {
-            [terms addObject:@"ORDER BY"];
-            [terms addObject:_orderBy];
-        }
-        self.sql = [terms componentsJoinedByString:@" "];
+    }
+    if (_orderBy) {
+        SCDBFilterAppendSQL([NSString stringWithFormat:@" ORDER BY %@", _orderBy], segments, paramNames);
+    }
+    [self setSqlSegments:segments paramNames:paramNames filterValues:filterValues];
+}
+
+- (NSArray *)applyTo:(SCDB *)db withParameters:(NSDictionary *)params {
+    // Compile the SQL. If the filter has been configured using table/filters/orderBy properties then
+    // _sql won't be set on first call.
+    if (!_sql && _table) {
+        [self compileFilters];
     }
     // If still no SQL then the filter hasn't been configured correctly.
     if (!_sql) {
         return @[];
     }
-    // Construct parameters for the SQL query.
+    // Construct parameters for the SQL query. Array values are expanded to lists of parameters, in
+    // which case the SQL is rebuilt from its segments.
     NSMutableArray *sqlParams = [[NSMutableArray alloc] init];
+    NSMutableString *expandedSql = nil;
+    NSInteger idx = 0;
     for (NSString *paramName in _paramNames) {
-        id value = [params valueForKey:paramName];
-        if (value != nil) {
-            [sqlParams addObject:value];
+        id value = _filterValues[paramName];
+        if (value == nil) {
+            value = [params valueForKey:paramName];
+        }
+        if ([value isKindOfClass:[NSArray class]]) {
+            if (!expandedSql) {
+                expandedSql = [NSMutableString new];
+                for (NSInteger i = 0; i < idx; i++) {
+                    [expandedSql appendString:_sqlSegments[i]];
+                    [expandedSql appendString:@"?"];
+                }
+            }
+            [expandedSql appendString:_sqlSegments[idx]];
+            NSArray *values = (NSArray *)value;
+            if ([values count]) {
+                // Pad the list by repeating its last value, so that the SQL (and its cached prepared
+                // statement) is reused for lists of similar sizes.
+                NSUInteger size = [SCSqliteDB INListSizeForCount:[values count]];
+                [expandedSql appendString:@"("];
+                for (NSUInteger i = 0; i < size; i++) {
+                    [expandedSql appendString:(i > 0 ? @",?" : @"?")];
+                }
+                [expandedSql appendString:@")"];
+                [sqlParams addObjectsFromArray:values];
+                for (NSUInteger i = [values count]; i < size; i++) {
+                    [sqlParams addObject:[values lastObject]];
+                }
+            }
+            else {
+                // An empty list matches nothing.
+                [expandedSql appendString:@"(NULL)"];
+            }
         }
         else {
-            [sqlParams addObject:[NSNull null]];
+            if (expandedSql) {
+                [expandedSql appendString:_sqlSegments[idx]];
+                [expandedSql appendString:@"?"];
+            }
+            [sqlParams addObject:(value != nil ? value : [NSNull null])];
         }
+        idx++;
+    }
+    NSString *sql = _sql;
+    if (expandedSql) {
+        [expandedSql appendString:[_sqlSegments lastObject]];
+        sql = expandedSql;
     }
     // Execute the SQL and return the result.
-    NSArray *result = [db performQuery:_sql withParams:sqlParams];
+    NSArray *result = [db performQuery:sql withParams:sqlParams];
     return result;
 }
 
+- (SCDBLiveQuery *)liveQueryOn:(SCDB *)db withParameters:(NSDictionary *)params {
+    NSArray *tables = @[];
+    if (_table) {
+        tables = @[ _table ];
+    }
+    else if (_sql) {
+        tables = [[SCDBLiveQuery tablesReadBySQL:_sql inDB:db] allObjects];
+    }
+    SCDBLiveQuery *query = [[SCDBLiveQuery alloc] initWithDB:db tables:tables query:^NSArray *(SCDB *database) {
+        return [self applyTo:database withParameters:params];
+    }];
+    if (_table) {
+        query.keyColumn = [db getColumnWithTag:@"id" fromTable:_table];
+    }
+    return query;
+}
+
 @end
+
+static void SCDBFilterAppendSQL(NSString *sql, NSMutableArray *segments, NSMutableArray *paramNames) {
+    static NSCharacterSet *NameChars;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSMutableCharacterSet *chars = [NSMutableCharacterSet alphanumericCharacterSet];
+        [chars addCharactersInString:@"_"];
+        NameChars = chars;
+    });
+    NSMutableString *segment = [segments lastObject];
+    NSUInteger length = [sql length];
+    NSUInteger start = 0, i = 0;
+    unichar quote = 0;
+    while (i < length) {
+        unichar ch = [sql characterAtIndex:i];
+        if (quote) {
+            // Skip over quoted strings and identifiers.
+            if (ch == quote) {
+                quote = 0;
+            }
+            i++;
+        }
+        else if (ch == '\'' || ch == '"') {
+            quote = ch;
+            i++;
+        }
+        else if (ch == '?' && i + 1 < length && [NameChars characterIsMember:[sql characterAtIndex:i + 1]]) {
+            NSUInteger end = i + 1;
+            while (end < length && [NameChars characterIsMember:[sql characterAtIndex:end]]) {
+                end++;
+            }
+            [segment appendString:[sql substringWithRange:NSMakeRange(start, i - start)]];
+            SCDBFilterAppendParam([sql substringWithRange:NSMakeRange(i + 1, end - i - 1)], segments, paramNames);
+            segment = [segments lastObject];
+            start = i = end;
+        }
+        else {
+            i++;
+        }
+    }
+    [segment appendString:[sql substringFromIndex:start]];
+}
+
+static void SCDBFilterAppendParam(NSString *name, NSMutableArray *segments, NSMutableArray *paramNames) {
+    [paramNames addObject:name];
+    [segments addObject:[NSMutableString new]];
+}
@@ -34,6 +34,16 @@
 
 @end
 
+/// A block performing operations on a database connection.
+typedef void (^SCDBHelperConnectionBlock) (SCSqliteDB *database);
+
+/**
+ * A database connection manager.
+ * All writes are serialised through a single writer connection. In WAL mode (the default), reads use a
+ * bounded pool of read-only connections so that they don't block behind writes; if WAL mode is disabled,
+ * or can't be enabled, then reads are also performed on the writer connection. The database is created or
+ * migrated on the writer connection the first time any connection is requested.
+ */
 @interface SCDBHelper : NSObject {
     /// The database name.
     NSString *_databaseName;
@@ -43,6 +53,22 @@
     NSString *_databasePath;
     /// Flag indicating whether the perform the initial copy check.
     BOOL _doInitialCopyCheck;
+    /// Flag indicating that the database has been opened and migrated.
+    BOOL _databaseReady;
+    /// The writer connection.
+    SCSqliteDB *_writer;
+    /// Lock serialising access to the writer connection.
+    NSRecursiveLock *_writerLock;
+    /// The thread currently holding the writer lock.
+    NSThread *_writerThread;
+    /// The number of times the writer lock is held by its current thread.
+    NSInteger _writerLockCount;
+    /// Idle read-only connections.
+    NSMutableArray *_readPool;
+    /// A semaphore bounding the number of read connections in use.
+    dispatch_semaphore_t _readSemaphore;
+    /// The thread dictionary key used to record a thread's current read connection.
+    NSString *_threadReaderKey;
 }
 
 /// Delegate for handling database creation / upgrade.
@@ -53,14 +79,48 @@
  * before a database connection is opened.
  */
 @property (nonatomic, strong) NSString *initialCopyPath;
+/// If true then the database is switched to WAL journal mode when opened, and the read pool is used. Defaults to YES.
+@property (nonatomic, assign) BOOL walMode;
+/// An optional value for the synchronous pragma on each connection, e.g. "NORMAL".
+@property (nonatomic, strong) NSString *synchronous;
+/// The maximum number of read connections. Must be set before the database is first read. Defaults to 4.
+@property (nonatomic, assign) NSUInteger readPoolSize;
+/// An optional profiler, assigned to each connection opened by the helper.
+@property (nonatomic, strong) SCSqliteProfiler *profiler;
 
 /// Initialize the helper with a database name and version.
 - (id)initWithName:(NSString *)name version:(int)version;
-/// Delete the database.
+/// Close all connections and delete the database, along with its WAL and shared memory files.
 - (BOOL)deleteDatabase;
-/// Get a connection to the database.
-- (SCSqliteDB *)getDatabase;
-/// Close the database.
+/**
+ * Open and migrate the database, if not already done.
+ * Returns NO if the database couldn't be opened, created or migrated. Connections are only available through the perform
+ * methods, and acquireWriter, so that their use is serialised.
+ */
+- (BOOL)openDatabase;
+/**
+ * Perform read operations on a pooled read-only connection (in WAL mode), or on the writer connection.
+ * Blocks until a connection is available. Reads performed by a thread currently holding the writer
+ * use the writer connection, so that they see its uncommitted changes; nested reads on the same
+ * thread use the same connection. Returns NO if a connection couldn't be opened.
+ */
+- (BOOL)performRead:(SCDBHelperConnectionBlock)block;
+/**
+ * Perform write operations on the writer connection.
+ * Blocks until the writer is available; calls may be nested on the same thread.
+ * Returns NO if the connection couldn't be opened.
+ */
+- (BOOL)performWrite:(SCDBHelperConnectionBlock)block;
+/**
+ * Acquire the writer connection for the current thread.
+ * Used to hold the writer across multiple calls, e.g. for the duration of a transaction. Each
+ * successful call must be balanced by a call to releaseWriter on the same thread.
+ * Returns nil if the connection couldn't be opened.
+ */
+- (SCSqliteDB *)acquireWriter;
+/// Release the writer connection.
+- (void)releaseWriter;
+/// Close all database connections.
 - (void)close;
 
 @end
@@ -19,10 +19,26 @@
 #import "SCDBHelper.h"
 #import "SCLogger.h"
 
-#define ThreadLocalDB   (@"SCDBHelper.database")
+#define DefaultReadPoolSize (4)
 
 static SCLogger *Logger;
 
+@interface SCDBHelper ()
+
+/// Open the writer connection and migrate the database, if not already done. Must hold the writer lock.
+- (SCSqliteDB *)openWriter;
+/// Open a new connection to the database.
+- (SCSqliteDB *)openConnectionReadOnly:(BOOL)readOnly;
+/// Migrate the database on the specified connection, if its version differs from the current version.
+/// Returns NO if the database version can't be read or the migration fails.
+- (BOOL)migrateDatabase:(SCSqliteDB *)database;
+/// Take a read connection from the pool, opening a new connection if necessary.
+- (SCSqliteDB *)checkoutReader;
+/// Return a read connection to the pool.
+- (void)checkinReader:(SCSqliteDB *)reader;
+
+@end
+
 @implementation SCDBHelper
 
 + (void)initialize {
@@ -41,103 +57,268 @@ static SCLogger *Logger;
         _databasePath = [documentsDirectory stringByAppendingPathComponent:[NSString stringWithFormat:@"%@.sqlite", _databaseName]];
         
         _doInitialCopyCheck = YES;
+        _writerLock = [NSRecursiveLock new];
+        _readPool = [NSMutableArray new];
+        _readPoolSize = DefaultReadPoolSize;
+        _walMode = YES;
+        _threadReaderKey = [NSString stringWithFormat:@"SCDBHelper.reader.%p", self];
     }
     return self;
 }
 
 - (BOOL)deleteDatabase {
+    // Close all connections first; SQLite could otherwise replay a stale WAL into a new database file.
+    [self close];
     BOOL ok = YES;
-    NSError *error = nil;
     NSFileManager *fileManager = [NSFileManager defaultManager];
-    if ([fileManager fileExistsAtPath:_databasePath]) {
-        [fileManager removeItemAtPath:_databasePath error:&error];
-        if (error) {
-            [Logger warn:@"Error deleting database at %@: %@", _databasePath, error];
-            ok = NO;
+    NSArray *paths = @[
+        _databasePath,
+        [_databasePath stringByAppendingString:@"-wal"],
+        [_databasePath stringByAppendingString:@"-shm"]
+    ];
+    for (NSString *path in paths) {
+        if ([fileManager fileExistsAtPath:path]) {
+            NSError *error = nil;
+            if (![fileManager removeItemAtPath:path error:&error]) {
+                [Logger warn:@"Error deleting database file at %@: %@", path, error];
+                ok = NO;
+            }
         }
     }
     return ok;
 }
 
-- (SCSqliteDB *)getDatabase {
-    NSMutableDictionary *threadLocals = [[NSThread currentThread] threadDictionary];
-    SCSqliteDB *database = threadLocals[ThreadLocalDB];
-    // Connect to database.
-    if (!(database != nil && database.open)) {
-
-        NSError *error = nil;
-
-        // Check whether to copy the initial DB copy.
-        if (_doInitialCopyCheck) {
-            // First check whether to deploy the initial database copy.
-            NSFileManager *fileManager = [NSFileManager defaultManager];
-            if (![fileManager fileExistsAtPath:_databasePath] && _initialCopyPath) {
-                [Logger debug:@"Copying initial database from %@", _initialCopyPath];
-                [fileManager copyItemAtPath:_initialCopyPath toPath:_databasePath error:&error];
-                if (error) {
-                    [Logger warn:@"Error copying initial database: %@", error];
-                }
+- (BOOL)openDatabase {
+    if (![self acquireWriter]) {
+        return NO;
+    }
+    [self releaseWriter];
+    return YES;
+}
+
+- (BOOL)performRead:(SCDBHelperConnectionBlock)block {
+    NSThread *currentThread = [NSThread currentThread];
+    // Reads by the thread holding the writer must see its uncommitted changes. Without WAL, a separate read
+    // connection would also block the writer from committing while the read is in progress, so use the writer.
+    if (_writerThread == currentThread || !_walMode) {
+        return [self performWrite:block];
+    }
+    NSMutableDictionary *threadLocals = [currentThread threadDictionary];
+    SCSqliteDB *reader = threadLocals[_threadReaderKey];
+    if (reader) {
+        // Nested read; reuse the thread's current connection rather than take another from the pool.
+        block(reader);
+        return YES;
+    }
+    reader = [self checkoutReader];
+    if (!reader) {
+        return NO;
+    }
+    threadLocals[_threadReaderKey] = reader;
+    block(reader);
+    [threadLocals removeObjectForKey:_threadReaderKey];
+    [self checkinReader:reader];
+    return YES;
+}
+
+- (BOOL)performWrite:(SCDBHelperConnectionBlock)block {
+    SCSqliteDB *writer = [self acquireWriter];
+    if (!writer) {
+        return NO;
+    }
+    block(writer);
+    [self releaseWriter];
+    return YES;
+}
+
+- (SCSqliteDB *)acquireWriter {
+    [_writerLock lock];
+    if (_writerLockCount++ == 0) {
+        _writerThread = [NSThread currentThread];
+    }
+    SCSqliteDB *writer = [self openWriter];
+    if (!writer) {
+        [self releaseWriter];
+    }
+    return writer;
+}
+
+- (void)releaseWriter {
+    if (--_writerLockCount == 0) {
+        _writerThread = nil;
+    }
+    [_writerLock unlock];
+}
+
+- (void)close {
+    [_writerLock lock];
+    [_writer close];
+    _writer = nil;
+    _databaseReady = NO;
+    [_writerLock unlock];
+    @synchronized (_readPool) {
+        for (SCSqliteDB *reader in _readPool) {
+            [reader close];
+        }
+        [_readPool removeAllObjects];
+    }
+}
+
+#pragma mark - private
+
+- (SCSqliteDB *)openWriter {
+    if (_writer && _writer.open) {
+        return _writer;
+    }
+    // Check whether to copy the initial DB copy.
+    if (_doInitialCopyCheck) {
+        // First check whether to deploy the initial database copy.
+        NSFileManager *fileManager = [NSFileManager defaultManager];
+        if (![fileManager fileExistsAtPath:_databasePath] && _initialCopyPath) {
+            [Logger debug:@"Copying initial database from %@", _initialCopyPath];
+            NSError *error = nil;
+            [fileManager copyItemAtPath:_initialCopyPath toPath:_databasePath error:&error];
+            if (error) {
+                [Logger warn:@"Error copying initial database: %@", error];
             }
-            _doInitialCopyCheck = NO;
         }
-        
-        // Open a connection to the DB.
-        database = [[SCSqliteDB alloc] initWithDBPath:_databasePath error:&error];
+        _doInitialCopyCheck = NO;
+    }
+    _writer = [self openConnectionReadOnly:NO];
+    if (_writer) {
+        if (_walMode) {
+            // Note that the journal mode is persistent, and applies to all connections.
+            NSError *error = nil;
+            SCSqliteResultSet *rs = [_writer executeQuery:@"PRAGMA journal_mode=WAL" error:&error];
+            NSString *journalMode = (!error && [rs next]) ? [rs columnValue:0] : nil;
+            [rs close];
+            if (![@"wal" isEqualToString:[journalMode lowercaseString]]) {
+                [Logger warn:@"Unable to enable WAL mode: %@", error ? [error localizedDescription] : journalMode];
+                // Perform reads on the writer connection.
+                _walMode = NO;
+            }
+        }
+        if (![self migrateDatabase:_writer]) {
+            // Don't use a database which couldn't be created or migrated; the migration is retried on the next open.
+            [_writer close];
+            _writer = nil;
+            return nil;
+        }
+        _databaseReady = YES;
+    }
+    return _writer;
+}
+
+- (SCSqliteDB *)openConnectionReadOnly:(BOOL)readOnly {
+    NSError *error = nil;
+    SCSqliteDB *database = [[SCSqliteDB alloc] initWithDBPath:_databasePath readOnly:readOnly error:&error];
+    if (error) {
+        [Logger error:@"Database open failure: %@", [error localizedDescription]];
+        return nil;
+    }
+    if (!database.open) {
+        return nil;
+    }
+    database.profiler = _profiler;
+    if (_synchronous) {
+        NSString *sql = [NSString stringWithFormat:@"PRAGMA synchronous=%@", _synchronous];
+        [database executeUpdate:sql error:&error];
         if (error) {
-            [Logger error:@"Database open failure: %@", [error localizedDescription]];
+            [Logger warn:@"Unable to set synchronous mode: %@", [error localizedDescription]];
         }
-        else if (database.open) {
-            // Read the database's current version.
-            SCSqliteResultSet *rs = [database executeQuery:@"PRAGMA user_version" error:&error];
-            if (error) {
-                [Logger error:@"Error reading database version: %@", [error localizedDescription]];
+    }
+    return database;
+}
+
+- (BOOL)migrateDatabase:(SCSqliteDB *)database {
+    BOOL ok = YES;
+    NSError *error = nil;
+    // Read the database's current version.
+    SCSqliteResultSet *rs = [database executeQuery:@"PRAGMA user_version" error:&error];
+    if (error) {
+        [Logger error:@"Error reading database version: %@", [error localizedDescription]];
+        ok = NO;
+    }
+    else if ([rs next]) {
+        NSInteger currentVersion = [rs columnValueAsInteger:0];
+        [rs close];
+        // Begin migration, if needed.
+        if (currentVersion != _databaseVersion) {
+            // Open a new transaction for the migration.
+            ok = [database executeUpdate:@"BEGIN EXCLUSIVE TRANSACTION" error:&error];
+            if (ok) {
+                // Perform the migration.
+                if (currentVersion == 0) {
+                    [_delegate onCreate:database error:&error];
+                }
+                else if (currentVersion < _databaseVersion) {
+                    [_delegate onUpgrade:database from:currentVersion to:_databaseVersion error:&error];
+                }
+                ok = (error == nil);
             }
-            else if ([rs next]) {
-                NSInteger currentVersion = [rs columnValueAsInteger:0];
-                [rs close];
-                // Begin migration, if needed.
-                if (currentVersion != _databaseVersion) {
-                    // Open a new transaction for the migration.
-                    [database executeUpdate:@"BEGIN EXCLUSIVE TRANSACTION" error:&error];
-                    if (!error) {
-                        // Perform the migration.
-                        if (currentVersion == 0) {
-                            [_delegate onCreate:database error:&error];
-                        }
-                        else if (currentVersion < _databaseVersion) {
-                            [_delegate onUpgrade:database from:currentVersion to:_databaseVersion error:&error];
-                        }
-                    }
-                    if (!error) {
-                        // Update the database version.
-                        NSString *sql = [NSString stringWithFormat:@"PRAGMA user_version = %d", _databaseVersion];
-                        [database executeUpdate:sql error:&error];
-                    }
-                    if (!error) {
-                        // Commit the migration.
-                        [database commitTransaction:&error];
-                    }
-                    else {
-                        [Logger error:@"Error migrating database: %@", [error localizedDescription]];
+            if (ok) {
+                // Update the database version.
+                NSString *sql = [NSString stringWithFormat:@"PRAGMA user_version = %d", _databaseVersion];
+                ok = [database executeUpdate:sql error:&error];
+            }
+            if (ok) {
+                // Commit the migration.
+                ok = [database commitTransaction:&error];
+            }
+            if (!ok) {
+                [Logger error:@"Error migrating database: %@", [error localizedDescription]];
+                // Roll back the partial migration, so that it is retried the next time the database is opened.
+                if ([database inTransaction]) {
+                    NSError *rollbackError = nil;
+                    if (![database rollbackTransaction:&rollbackError]) {
+                        [Logger error:@"Error rolling back migration: %@", [rollbackError localizedDescription]];
                     }
                 }
             }
-            else {
-                [Logger error:@"Unable to read database version"];
-            }
         }
-        threadLocals[ThreadLocalDB] = database;
     }
-    return database.open ? database : nil;
+    else {
+        [rs close];
+        [Logger error:@"Unable to read database version"];
+        ok = NO;
+    }
+    return ok;
 }
 
-- (void)close {
-    NSMutableDictionary *threadLocals = [[NSThread currentThread] threadDictionary];
-    SCSqliteDB *database = threadLocals[ThreadLocalDB];
-    if (database) {
-        [database close];
-        [threadLocals removeObjectForKey:ThreadLocalDB];
+- (SCSqliteDB *)checkoutReader {
+    if (!_databaseReady) {
+        // Make sure the database exists and is migrated before opening any read connections.
+        if (![self openDatabase]) {
+            return nil;
+        }
+    }
+    @synchronized (self) {
+        if (!_readSemaphore) {
+            _readSemaphore = dispatch_semaphore_create(MAX(_readPoolSize, 1));
+        }
+    }
+    dispatch_semaphore_wait(_readSemaphore, DISPATCH_TIME_FOREVER);
+    SCSqliteDB *reader = nil;
+    @synchronized (_readPool) {
+        reader = [_readPool lastObject];
+        if (reader) {
+            [_readPool removeLastObject];
+        }
+    }
+    if (!(reader && reader.open)) {
+        reader = [self openConnectionReadOnly:YES];
+        if (!reader) {
+            dispatch_semaphore_signal(_readSemaphore);
+        }
+    }
+    return reader;
+}
+
+- (void)checkinReader:(SCSqliteDB *)reader {
+    @synchronized (_readPool) {
+        [_readPool addObject:reader];
     }
+    dispatch_semaphore_signal(_readSemaphore);
 }
 
 @end
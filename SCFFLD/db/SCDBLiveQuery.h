@@ -0,0 +1,122 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "SCDB.h"
+
+/**
+ * The differences between two results of a live query.
+ * Removed and moved-from indexes refer to the previous result; inserted, updated and moved-to
+ * indexes refer to the new result. The differences are suitable for animating table and collection
+ * view updates.
+ */
+@interface SCDBLiveQueryDiff : NSObject
+
+/// The indexes of rows removed from the previous result.
+@property (nonatomic, strong, readonly) NSIndexSet *removedIndexes;
+/// The indexes of rows inserted into the new result.
+@property (nonatomic, strong, readonly) NSIndexSet *insertedIndexes;
+/// The indexes of rows, with the same key, whose values have changed; only reported when rows are keyed.
+@property (nonatomic, strong, readonly) NSIndexSet *updatedIndexes;
+/// Rows which have moved, as a list of _[from index, to index]_ pairs.
+@property (nonatomic, strong, readonly) NSArray *moves;
+/// Test whether the results are the same.
+@property (nonatomic, readonly) BOOL isEmpty;
+
+/**
+ * Calculate the differences between two results.
+ * @param keyColumn The name of a column uniquely identifying each row; or _nil_ to compare whole rows.
+ */
++ (SCDBLiveQueryDiff *)diffFromRows:(NSArray *)oldRows toRows:(NSArray *)newRows keyColumn:(NSString *)keyColumn;
+
+@end
+
+/// A block performing a live query.
+typedef NSArray *(^SCDBLiveQueryBlock) (SCDB *db);
+/**
+ * A block receiving live query results.
+ * @param rows  The query result.
+ * @param diff  The differences from the previous result; _nil_ for the first result delivered.
+ */
+typedef void (^SCDBLiveQuerySubscriber) (NSArray *rows, SCDBLiveQueryDiff *diff);
+
+/**
+ * A query whose result is kept up to date as the database changes.
+ * The query is re-run whenever a change observed on the database (see SCDB's
+ * addChangeObserverForTables:usingBlock:) includes one of the tables it reads; a burst of writes
+ * results in at most one re-run per debounce interval. Subscribers are only called when the result
+ * actually changes, with the new result and its differences from the previous result.
+ * Queries run on a background queue; subscribers are called on the database's asyncResultQueue.
+ */
+@interface SCDBLiveQuery : NSObject {
+    /// The query.
+    SCDBLiveQueryBlock _query;
+    /// Registered subscribers.
+    NSMutableArray *_subscribers;
+    /// The database change observer, while the query is started.
+    id _changeObserver;
+    /// The queue the query runs on.
+    dispatch_queue_t _queue;
+    /// A flag indicating that the query is due to be re-run.
+    BOOL _refreshScheduled;
+}
+
+/**
+ * Initialize a live query.
+ * @param db        The database to query.
+ * @param tables    The names of the tables read by the query.
+ * @param query     A block performing the query.
+ */
+- (id)initWithDB:(SCDB *)db tables:(NSArray *)tables query:(SCDBLiveQueryBlock)query;
+/**
+ * Initialize a live SQL query.
+ * The tables read by the query are found from the SQL's FROM and JOIN clauses, and matched to the
+ * database's declared table names regardless of case. Use initWithDB:tables:query: to name the tables
+ * explicitly when they can't be found from the SQL, e.g. when they're only read by views or triggers.
+ */
+- (id)initWithDB:(SCDB *)db sql:(NSString *)sql params:(NSArray *)params;
+
+/// The database.
+@property (nonatomic, weak, readonly) SCDB *db;
+/// The names of the tables read by the query.
+@property (nonatomic, strong, readonly) NSSet *tables;
+/// The name of a column uniquely identifying each result row, used to match rows between results.
+@property (nonatomic, strong) NSString *keyColumn;
+/// The minimum interval, in seconds, between re-runs of the query. Defaults to 0.05.
+@property (nonatomic, assign) NSTimeInterval debounceInterval;
+/// The most recent query result; or _nil_ if the query hasn't yet completed.
+@property (strong, readonly) NSArray *rows;
+
+/// Start observing the database, and run the query.
+- (void)start;
+/// Stop observing the database.
+- (void)stop;
+/**
+ * Add a subscriber.
+ * If the query has a result then the subscriber is called with it, without a diff.
+ * @return A subscription token, for use with removeSubscriber:.
+ */
+- (id)addSubscriber:(SCDBLiveQuerySubscriber)subscriber;
+/// Remove a subscriber.
+- (void)removeSubscriber:(id)subscription;
+
+/// Return the names of the tables referenced in an SQL query's FROM and JOIN clauses, including comma separated FROM lists.
++ (NSSet *)tablesReadBySQL:(NSString *)sql;
+/// Return the names of the tables referenced by an SQL query, using the database's spelling of each declared table name.
++ (NSSet *)tablesReadBySQL:(NSString *)sql inDB:(SCDB *)db;
+
+@end
@@ -0,0 +1,345 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCDBLiveQuery.h"
+
+/// A key identifying a whole result row.
+@interface SCDBLiveQueryRowKey : NSObject <NSCopying> {
+    NSDictionary *_row;
+    NSUInteger _hash;
+}
+
+- (id)initWithRow:(NSDictionary *)row;
+
+@end
+
+@implementation SCDBLiveQueryRowKey
+
+- (id)initWithRow:(NSDictionary *)row {
+    self = [super init];
+    if (self) {
+        _row = row;
+        // NSDictionary's own hash is its count; combine the hashes of its values instead.
+        for (id key in row) {
+            _hash ^= [key hash] * 31 + [row[key] hash];
+        }
+    }
+    return self;
+}
+
+- (NSUInteger)hash {
+    return _hash;
+}
+
+- (BOOL)isEqual:(id)object {
+    return [object isKindOfClass:[SCDBLiveQueryRowKey class]] && [_row isEqualToDictionary:((SCDBLiveQueryRowKey *)object)->_row];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;
+}
+
+@end
+
+@interface SCDBLiveQueryDiff ()
+
+@property (nonatomic, strong, readwrite) NSIndexSet *removedIndexes;
+@property (nonatomic, strong, readwrite) NSIndexSet *insertedIndexes;
+@property (nonatomic, strong, readwrite) NSIndexSet *updatedIndexes;
+@property (nonatomic, strong, readwrite) NSArray *moves;
+
+@end
+
+@implementation SCDBLiveQueryDiff
+
+- (BOOL)isEmpty {
+    return [_removedIndexes count] == 0 && [_insertedIndexes count] == 0 && [_updatedIndexes count] == 0 && [_moves count] == 0;
+}
+
++ (SCDBLiveQueryDiff *)diffFromRows:(NSArray *)oldRows toRows:(NSArray *)newRows keyColumn:(NSString *)keyColumn {
+    id (^keyForRow)(NSDictionary *) = ^id(NSDictionary *row) {
+        if (keyColumn) {
+            id key = row[keyColumn];
+            return key ?: [NSNull null];
+        }
+        return [[SCDBLiveQueryRowKey alloc] initWithRow:row];
+    };
+    // Map each row key in the previous result to its indexes, in order.
+    NSUInteger oldCount = [oldRows count];
+    NSMutableDictionary *oldIndexes = [[NSMutableDictionary alloc] initWithCapacity:oldCount];
+    for (NSUInteger i = 0; i < oldCount; i++) {
+        id key = keyForRow(oldRows[i]);
+        NSMutableArray *indexes = oldIndexes[key];
+        if (!indexes) {
+            indexes = [NSMutableArray new];
+            oldIndexes[key] = indexes;
+        }
+        [indexes addObject:[NSNumber numberWithUnsignedInteger:i]];
+    }
+    // Match each new row with a previous row with the same key.
+    NSUInteger newCount = [newRows count];
+    NSUInteger *sources = malloc(MAX(newCount, 1) * sizeof(NSUInteger));
+    NSMutableIndexSet *matched = [NSMutableIndexSet new];
+    NSMutableIndexSet *inserted = [NSMutableIndexSet new];
+    NSMutableIndexSet *updated = [NSMutableIndexSet new];
+    for (NSUInteger j = 0; j < newCount; j++) {
+        NSMutableArray *indexes = oldIndexes[keyForRow(newRows[j])];
+        if ([indexes count]) {
+            NSUInteger i = [indexes[0] unsignedIntegerValue];
+            [indexes removeObjectAtIndex:0];
+            sources[j] = i;
+            [matched addIndex:i];
+            if (keyColumn && ![oldRows[i] isEqual:newRows[j]]) {
+                [updated addIndex:j];
+            }
+        }
+        else {
+            sources[j] = NSNotFound;
+            [inserted addIndex:j];
+        }
+    }
+    NSMutableIndexSet *removed = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, oldCount)];
+    [removed removeIndexes:matched];
+    // Matched rows keeping their relative order are those in the longest increasing run of their
+    // previous indexes; all other matched rows have moved.
+    NSUInteger *tails = malloc(MAX(newCount, 1) * sizeof(NSUInteger));
+    NSUInteger *previous = malloc(MAX(newCount, 1) * sizeof(NSUInteger));
+    NSUInteger length = 0;
+    for (NSUInteger j = 0; j < newCount; j++) {
+        if (sources[j] == NSNotFound) {
+            continue;
+        }
+        NSUInteger lo = 0, hi = length;
+        while (lo < hi) {
+            NSUInteger mid = (lo + hi) / 2;
+            if (sources[tails[mid]] < sources[j]) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        previous[j] = lo > 0 ? tails[lo - 1] : NSNotFound;
+        tails[lo] = j;
+        if (lo == length) {
+            length++;
+        }
+    }
+    NSMutableIndexSet *stable = [NSMutableIndexSet new];
+    for (NSUInteger j = length > 0 ? tails[length - 1] : NSNotFound; j != NSNotFound; j = previous[j]) {
+        [stable addIndex:j];
+    }
+    NSMutableArray *moves = [NSMutableArray new];
+    for (NSUInteger j = 0; j < newCount; j++) {
+        if (sources[j] != NSNotFound && ![stable containsIndex:j]) {
+            [moves addObject:@[ [NSNumber numberWithUnsignedInteger:sources[j]], [NSNumber numberWithUnsignedInteger:j] ]];
+        }
+    }
+    free(sources);
+    free(tails);
+    free(previous);
+    SCDBLiveQueryDiff *diff = [SCDBLiveQueryDiff new];
+    diff.removedIndexes = removed;
+    diff.insertedIndexes = inserted;
+    diff.updatedIndexes = updated;
+    diff.moves = moves;
+    return diff;
+}
+
+@end
+
+@interface SCDBLiveQuery ()
+
+@property (strong, readwrite) NSArray *rows;
+
+/// Schedule a re-run of the query after the debounce interval.
+- (void)setNeedsRefresh;
+/// Run the query, and notify subscribers if its result has changed.
+- (void)refresh;
+/// The queue subscribers are called on.
+- (dispatch_queue_t)resultQueue;
+
+@end
+
+@implementation SCDBLiveQuery
+
+- (id)initWithDB:(SCDB *)db tables:(NSArray *)tables query:(SCDBLiveQueryBlock)query {
+    self = [super init];
+    if (self) {
+        _db = db;
+        _tables = [NSSet setWithArray:tables];
+        _query = query;
+        _subscribers = [NSMutableArray new];
+        _queue = dispatch_queue_create("SCDBLiveQuery", DISPATCH_QUEUE_SERIAL);
+        _debounceInterval = 0.05;
+    }
+    return self;
+}
+
+- (id)initWithDB:(SCDB *)db sql:(NSString *)sql params:(NSArray *)params {
+    NSArray *tables = [[SCDBLiveQuery tablesReadBySQL:sql inDB:db] allObjects];
+    return [self initWithDB:db tables:tables query:^NSArray *(SCDB *database) {
+        return [database performQuery:sql withParams:params];
+    }];
+}
+
+- (void)dealloc {
+    [self stop];
+}
+
+- (void)start {
+    @synchronized (self) {
+        if (_changeObserver) {
+            return;
+        }
+        __weak SCDBLiveQuery *weakSelf = self;
+        _changeObserver = [_db addChangeObserverForTables:[_tables allObjects] usingBlock:^(SCDBChangeSet *changes) {
+            [weakSelf setNeedsRefresh];
+        }];
+    }
+    dispatch_async(_queue, ^{
+        [self refresh];
+    });
+}
+
+- (void)stop {
+    @synchronized (self) {
+        if (_changeObserver) {
+            [_db removeChangeObserver:_changeObserver];
+            _changeObserver = nil;
+        }
+    }
+}
+
+- (id)addSubscriber:(SCDBLiveQuerySubscriber)subscriber {
+    subscriber = [subscriber copy];
+    @synchronized (self) {
+        [_subscribers addObject:subscriber];
+        // Deliver the current result while synchronized, so that it's delivered before any later diff.
+        NSArray *rows = self.rows;
+        if (rows) {
+            dispatch_async([self resultQueue], ^{
+                subscriber(rows, nil);
+            });
+        }
+    }
+    return subscriber;
+}
+
+- (void)removeSubscriber:(id)subscription {
+    @synchronized (self) {
+        [_subscribers removeObjectIdenticalTo:subscription];
+    }
+}
+
++ (NSSet *)tablesReadBySQL:(NSString *)sql {
+    static NSRegularExpression *TableReferencePattern, *TableListPattern;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // A table reference is an optionally schema qualified and quoted name, with an optional alias;
+        // keywords which can follow a table name aren't mistaken for aliases.
+        NSString *reference = @"(?:\\w+\\.)?[\"\\[`]?(\\w+)[\"\\]`]?(?:\\s+(?:AS\\s+)?"
+                              "(?!(?:WHERE|ON|USING|JOIN|INNER|LEFT|RIGHT|CROSS|NATURAL|FULL|OUTER|GROUP|ORDER|LIMIT|"
+                              "HAVING|WINDOW|UNION|EXCEPT|INTERSECT|INDEXED|NOT)\\b)\\w+)?";
+        TableReferencePattern = [NSRegularExpression regularExpressionWithPattern:[@"\\b(?:FROM|JOIN)\\s+" stringByAppendingString:reference]
+                                                                          options:NSRegularExpressionCaseInsensitive
+                                                                            error:nil];
+        // Further tables in a comma separated FROM list.
+        TableListPattern = [NSRegularExpression regularExpressionWithPattern:[@"\\s*,\\s*" stringByAppendingString:reference]
+                                                                     options:NSRegularExpressionCaseInsensitive
+                                                                       error:nil];
+    });
+    NSMutableSet *tables = [NSMutableSet new];
+    NSUInteger length = [sql length];
+    [TableReferencePattern enumerateMatchesInString:sql options:0 range:NSMakeRange(0, length)
+                                         usingBlock:^(NSTextCheckingResult *match, NSMatchingFlags flags, BOOL *stop) {
+        [tables addObject:[sql substringWithRange:[match rangeAtIndex:1]]];
+        NSUInteger position = NSMaxRange([match range]);
+        NSTextCheckingResult *next;
+        while ((next = [TableListPattern firstMatchInString:sql options:NSMatchingAnchored range:NSMakeRange(position, length - position)])) {
+            [tables addObject:[sql substringWithRange:[next rangeAtIndex:1]]];
+            position = NSMaxRange([next range]);
+        }
+    }];
+    return tables;
+}
+
++ (NSSet *)tablesReadBySQL:(NSString *)sql inDB:(SCDB *)db {
+    // Table names in SQL are case insensitive, but change sets are keyed by the names the database declares.
+    NSMutableDictionary *declaredNames = [NSMutableDictionary new];
+    for (NSString *table in db.tables) {
+        declaredNames[[table lowercaseString]] = table;
+    }
+    NSMutableSet *tables = [NSMutableSet new];
+    for (NSString *table in [SCDBLiveQuery tablesReadBySQL:sql]) {
+        [tables addObject:declaredNames[[table lowercaseString]] ?: table];
+    }
+    return tables;
+}
+
+#pragma mark - Private methods
+
+- (void)setNeedsRefresh {
+    @synchronized (self) {
+        if (_refreshScheduled || !_changeObserver) {
+            return;
+        }
+        _refreshScheduled = YES;
+    }
+    // Writes made before the query is re-run are all seen by the one re-run.
+    dispatch_time_t time = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_debounceInterval * NSEC_PER_SEC));
+    dispatch_after(time, _queue, ^{
+        [self refresh];
+    });
+}
+
+- (void)refresh {
+    @synchronized (self) {
+        // Changes made from here on need another re-run.
+        _refreshScheduled = NO;
+    }
+    SCDB *db = _db;
+    if (!db) {
+        return;
+    }
+    NSArray *rows = _query(db) ?: @[];
+    NSArray *previousRows = self.rows;
+    SCDBLiveQueryDiff *diff = nil;
+    if (previousRows) {
+        diff = [SCDBLiveQueryDiff diffFromRows:previousRows toRows:rows keyColumn:_keyColumn];
+        if ([diff isEmpty]) {
+            return;
+        }
+    }
+    @synchronized (self) {
+        self.rows = rows;
+        NSArray *subscribers = [_subscribers copy];
+        if ([subscribers count]) {
+            dispatch_async([self resultQueue], ^{
+                for (SCDBLiveQuerySubscriber subscriber in subscribers) {
+                    subscriber(rows, diff);
+                }
+            });
+        }
+    }
+}
+
+- (dispatch_queue_t)resultQueue {
+    return _db.asyncResultQueue ?: dispatch_get_main_queue();
+}
+
+@end
@@ -19,8 +19,23 @@
 #import <Foundation/Foundation.h>
 #import "SCIOCTypeInspectable.h"
 #import "SCIOCObjectAware.h"
+#import "Q.h"
 
 @class SCDB;
+@class SCDBLiveQuery;
+
+/// Strategies for loading collection (map/dictionary/array/list) relations.
+typedef NS_ENUM(NSInteger, SCDBORMCollectionStrategy) {
+    /// Collection relations are outer joined to the source table, in a single query.
+    SCDBORMCollectionStrategyJoin,
+    /**
+     * Source objects are loaded first, and then each collection relation is loaded with a separate, batched
+     * _ownerid IN (...)_ query. This avoids the cartesian product of rows returned when joining more than one
+     * collection. Note that where and order by clauses may then only refer to the source table and to
+     * object/property relations.
+     */
+    SCDBORMCollectionStrategyBatched
+};
 
 /**
  * A class providing simple object-relational mapping capability.
@@ -29,7 +44,10 @@
  * between the source table and other related tables, with 1:1, 1:Many and Many:1 relations
  * supported.
  */
-@interface SCDBORM : NSObject <SCIOCTypeInspectable, SCIOCObjectAware>
+@interface SCDBORM : NSObject <SCIOCTypeInspectable, SCIOCObjectAware> {
+    /// Compiled select statements, keyed by mapping names, where and order by clauses.
+    NSMutableDictionary *_selectCache;
+}
 
 /// The name of the relation source table.
 @property (nonatomic, strong) NSString *source;
@@ -37,11 +55,15 @@
 @property (nonatomic, strong) NSDictionary *mappings;
 /// The database.
 @property (nonatomic, weak) SCDB *db;
+/// The strategy used to load collection relations. Defaults to SCDBORMCollectionStrategyJoin.
+@property (nonatomic, assign) SCDBORMCollectionStrategy collectionStrategy;
 
 /**
  * Select the object with the specified key value.
  * Returns the object record from the source table, with all related properties
  * named in the mappings argument joined from the related tables.
+ * When the database caches records for the source table, the object is read through the
+ * database's record cache, and the result is shared and mustn't be modified.
  */
 - (NSDictionary *)selectKey:(NSString *)key mappings:(NSArray *)mappings;
 /**
@@ -56,6 +78,32 @@
  * named in the mappings argument joined from the related tables.
  */
 - (NSArray *)selectWhere:(NSString *)where values:(NSArray *)values mappings:(NSArray *)mappings orderBy:(NSString *)orderBy;
+/**
+ * Select the objects matching the specified where condition asynchronously.
+ * Returns a promise resolved with an array of object records; see selectWhere:values:mappings:.
+ */
+- (QPromise *)selectWhereAsync:(NSString *)where values:(NSArray *)values mappings:(NSArray *)mappings;
+/**
+ * Return a live query selecting the objects matching the specified where condition.
+ * The query is re-run when the source table or the tables of the named mappings change; result rows
+ * are matched by the source table's ID. The query must be started; see SCDBLiveQuery.
+ */
+- (SCDBLiveQuery *)liveSelectWhere:(NSString *)where values:(NSArray *)values mappings:(NSArray *)mappings orderBy:(NSString *)orderBy;
+/**
+ * Save an object.
+ * The object is decomposed into a source table record and relation table records according to the
+ * ORM mappings; see saveObjects:.
+ */
+- (BOOL)saveObject:(NSDictionary *)object;
+/**
+ * Save a list of objects.
+ * Each object is decomposed into a source table record and records for each of its relation properties,
+ * and all records are written using batched upserts within a single transaction. Only relations present
+ * on an object are written. Collection members not in an object's collection are deleted; members with
+ * an ID are upserted, but if any member lacks an ID then all of the collection's existing members are
+ * replaced. Shared object values must include their ID. Returns YES if all objects were saved.
+ */
+- (BOOL)saveObjects:(NSArray *)objects;
 /**
  * Delete the object with the specified key value.
  * Deletes any related records unique to the deleted object.
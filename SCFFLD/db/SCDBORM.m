@@ -18,21 +18,132 @@
 
 #import "SCDBORM.h"
 #import "SCDB.h"
+#import "SCDBLiveQuery.h"
+#import "NSArray+SC.h"
+#import "SCLogger.h"
+
+static SCLogger *Logger;
+
+/// The maximum number of compiled select statements cached by an ORM instance.
+#define SelectCacheSize (64)
+
+/// A compiled query for the members of a collection relation, used with the batched collection strategy.
+@interface SCDBORMCollectionQuery : NSObject {
+    @public
+    /// The relation name.
+    NSString *_name;
+    /// The select SQL, with an IN list marker for the owner IDs.
+    NSString *_sql;
+    /// The property name of each result column.
+    NSArray *_propertyNames;
+    /// The result column index of the owner ID column.
+    NSInteger _ownerColumnIndex;
+}
+
+@end
+
+@implementation SCDBORMCollectionQuery
+
+@end
+
+/**
+ * A compiled ORM select statement.
+ * Records the statement's SQL, and how each of its result columns maps to a property of
+ * the source object or of one of its relations.
+ */
+@interface SCDBORMSelect : NSObject {
+    @public
+    /// The select SQL.
+    NSString *_sql;
+    /// The number of result column groups. The first group is the source table, followed by one per relation.
+    NSInteger _groupCount;
+    /// The relation name of each group.
+    NSArray *_groupNames;
+    /// The index of the first result column of each group, followed by the total result column count.
+    NSInteger *_groupStarts;
+    /// Flags indicating which groups are collection (one to many) relations.
+    BOOL *_groupIsCollection;
+    /// The property name of each result column within its group.
+    NSArray *_propertyNames;
+    /// The result column index of the source table's ID column.
+    NSInteger _keyColumnIndex;
+    /// Queries for collection relations which are loaded separately from the source objects.
+    NSArray *_collectionQueries;
+}
+
+@end
+
+@implementation SCDBORMSelect
+
+- (void)dealloc {
+    free(_groupStarts);
+    free(_groupIsCollection);
+}
+
+@end
 
 @interface SCDBORM()
 
-- (NSString *)columnNamesForTable:(NSString *)table withPrefix:(NSString *)prefix;
+/// Return the column names of a table, as a SQL select list, adding each column's name to a list of property names.
+- (NSString *)columnNamesForTable:(NSString *)table withPrefix:(NSString *)prefix propertyNames:(NSMutableArray *)propertyNames;
 - (NSString *)idColumnForTable:(NSString *)table;
+/// Discard all compiled select statements.
+- (void)clearSelectCache;
+/// Return a compiled select statement, from the cache if available.
+- (SCDBORMSelect *)selectWhere:(NSString *)where mappings:(NSArray *)mappings orderBy:(NSString *)orderBy;
+/// Add a row to the list of rows to be written to a table.
+- (void)addRow:(NSDictionary *)row forTable:(NSString *)table to:(NSMutableDictionary *)tableRows;
+/// Return the member rows of a collection relation value, with owner ID and key/index values set.
+- (NSArray *)membersOfCollection:(id)collection mapping:(SCDBORMMapping *)mapping ownerID:(id)ownerID;
+/// Upsert rows into their tables.
+- (BOOL)upsertTableRows:(NSDictionary *)tableRows;
+/// Load the members of a collection relation for a list of objects, in chunks of owner IDs.
+- (void)loadCollection:(SCDBORMCollectionQuery *)query forObjects:(NSArray *)objects withIDColumn:(NSString *)idColumn;
+/// Compile a select statement for a set of mappings.
+- (SCDBORMSelect *)compileSelectWhere:(NSString *)where mappingNames:(NSArray *)mappingNames orderBy:(NSString *)orderBy;
 
 @end
 
 @implementation SCDBORM
 
++ (void)initialize {
+    Logger = [[SCLogger alloc] initWithTag:@"SCDBORM"];
+}
+
 - (NSDictionary *)selectKey:(NSString *)key mappings:(NSArray *)mappings {
+    // Objects are cached in a record cache view per source table and set of mappings, which is
+    // cleared whenever any of the tables read are written.
+    SCDBRecordCache *recordCache = _db.recordCache;
+    NSString *view = nil;
+    NSMutableArray *tables = nil;
+    uint64_t generation = 0;
+    if (key && [recordCache cachesTable:_source]) {
+        NSMutableSet *mappingNames = [NSMutableSet new];
+        tables = [NSMutableArray arrayWithObject:_source];
+        for (NSString *mname in mappings) {
+            SCDBORMMapping *mapping = _mappings[mname];
+            if (mapping) {
+                [mappingNames addObject:mname];
+                if (mapping.table) {
+                    [tables addObject:mapping.table];
+                }
+            }
+        }
+        NSArray *sortedNames = [[mappingNames allObjects] sortedArrayUsingSelector:@selector(compare:)];
+        view = [NSString stringWithFormat:@"%@:%@", _source, [sortedNames componentsJoinedByString:@","]];
+        NSDictionary *object = [recordCache recordWithID:key inTable:view generation:&generation];
+        if (object) {
+            return object;
+        }
+    }
     NSString *idColumn = [self idColumnForTable:_source];
     NSString *where = [NSString stringWithFormat:@"%@.%@=?", _source, idColumn];
     NSArray *result = [self selectWhere:where values:@[ key ] mappings:mappings];
-    return [result count] ? result[0] : nil;
+    NSDictionary *object = [result count] ? result[0] : nil;
+    if (view) {
+        [recordCache setRecord:object withID:key inView:view dependingOnTables:tables generation:generation];
+    }
+    return object;
 }
 
 - (NSArray *)selectWhere:(NSString *)where values:(NSArray *)values mappings:(NSArray *)mappings {
@@ -41,6 +152,340 @@
 
 - (NSArray *)selectWhere:(NSString *)where values:(NSArray *)values mappings:(NSArray *)mappings orderBy:(NSString *)orderBy {
     
+    // Note that the statement must outlive the enumeration, which uses its column tables.
+    SCDBORMSelect *select NS_VALID_UNTIL_END_OF_SCOPE = [self selectWhere:where mappings:mappings orderBy:orderBy];
+    NSInteger groupCount = select->_groupCount;
+    NSInteger *groupStarts = select->_groupStarts;
+    BOOL *groupIsCollection = select->_groupIsCollection;
+    NSArray *groupNames = select->_groupNames;
+    NSArray *propertyNames = select->_propertyNames;
+    NSInteger keyColumnIndex = select->_keyColumnIndex;
+    
+    // Execute the query and generate the result.
+    NSMutableArray *result = [NSMutableArray new];
+    // The object currently being processed, and its key.
+    __block NSMutableDictionary *obj = nil;
+    __block id objKey = nil;
+    [_db enumerateQuery:select->_sql params:values usingResultSetBlock:^(SCSqliteResultSet *rs, BOOL *stop) {
+        // Read the key value from the current result set row, and check if dealing with a new object.
+        id key = (keyColumnIndex != NSNotFound) ? [rs columnValue:keyColumnIndex] : nil;
+        BOOL newObject = (obj == nil || ![objKey isEqual:key]);
+        // Convert the flat result set row into groups of properties; the source table is the first group.
+        for (NSInteger gidx = newObject ? 0 : 1; gidx < groupCount; gidx++) {
+            BOOL isCollection = groupIsCollection[gidx];
+            if (!(newObject || isCollection)) {
+                // Subsequent rows for the same object only add collection values.
+                continue;
+            }
+            NSMutableDictionary *group = nil;
+            for (NSInteger cidx = groupStarts[gidx]; cidx < groupStarts[gidx + 1]; cidx++) {
+                // Only map columns with values.
+                if (![rs isColumnValueNull:cidx]) {
+                    if (!group) {
+                        group = [NSMutableDictionary new];
+                    }
+                    group[propertyNames[cidx]] = [rs columnValue:cidx];
+                }
+            }
+            if (gidx == 0) {
+                obj = group ?: [NSMutableDictionary new];
+                objKey = key;
+                [result addObject:obj];
+                continue;
+            }
+            NSString *rname = groupNames[gidx];
+            if (isCollection && newObject) {
+                // A one to many relation; init the object property as an array of values.
+                if (group) {
+                    obj[rname] = [[NSMutableArray alloc] initWithObjects:group, nil];
+                }
+            }
+            else if (isCollection) {
+                // Processing subsequent rows for the same object - indicates outer join results.
+                NSMutableArray *values = obj[rname];
+                if (!values) {
+                    // Ensure that we have a list to hold the additional values.
+                    values = [NSMutableArray new];
+                    obj[rname] = values;
+                }
+                if (group) {
+                    [values addObject:group];
+                }
+            }
+            else if (group) {
+                // Else map the object property name to the value.
+                obj[rname] = group;
+            }
+        }
+    }];
+    // Load any collection relations not joined into the main query.
+    if ([result count]) {
+        NSString *sidColumn = [self idColumnForTable:_source];
+        for (SCDBORMCollectionQuery *query in select->_collectionQueries) {
+            [self loadCollection:query forObjects:result withIDColumn:sidColumn];
+        }
+    }
+    return result;
+}
+
+- (QPromise *)selectWhereAsync:(NSString *)where values:(NSArray *)values mappings:(NSArray *)mappings {
+    return [_db performReadAsync:^id(NSError **error) {
+        return [self selectWhere:where values:values mappings:mappings];
+    }];
+}
+
+- (SCDBLiveQuery *)liveSelectWhere:(NSString *)where values:(NSArray *)values mappings:(NSArray *)mappings orderBy:(NSString *)orderBy {
+    NSMutableArray *tables = [NSMutableArray arrayWithObject:_source];
+    for (NSString *mname in mappings) {
+        SCDBORMMapping *mapping = _mappings[mname];
+        if (mapping.table) {
+            [tables addObject:mapping.table];
+        }
+    }
+    __weak SCDBORM *weakSelf = self;
+    SCDBLiveQuery *query = [[SCDBLiveQuery alloc] initWithDB:_db tables:tables query:^NSArray *(SCDB *db) {
+        return [weakSelf selectWhere:where values:values mappings:mappings orderBy:orderBy];
+    }];
+    query.keyColumn = [self idColumnForTable:_source];
+    return query;
+}
+
+- (BOOL)saveObject:(NSDictionary *)object {
+    return [self saveObjects:@[ object ]];
+}
+
+- (BOOL)saveObjects:(NSArray *)objects {
+    // The name of the ID column on the source table.
+    NSString *sidColumn = [self idColumnForTable:_source];
+    if (!sidColumn) {
+        [Logger warn:@"No ID column found for table %@", _source];
+        return NO;
+    }
+    // Decompose the objects into rows for each table; rows are written in the order:
+    // shared objects, source objects, object properties, collection deletes, collection members.
+    NSMutableDictionary *sharedRows = [NSMutableDictionary new];
+    NSMutableArray *sourceRows = [NSMutableArray new];
+    NSMutableDictionary *objectRows = [NSMutableDictionary new];
+    NSMutableArray *deletes = [NSMutableArray new];     // Array of [ sql, params ] pairs.
+    NSMutableDictionary *memberRows = [NSMutableDictionary new];
+    for (NSDictionary *object in objects) {
+        id sid = object[sidColumn];
+        if (!sid) {
+            [Logger warn:@"Unable to save %@ object without an ID", _source];
+            return NO;
+        }
+        NSMutableDictionary *sourceRow = [object mutableCopy];
+        for (NSString *mname in [_mappings keyEnumerator]) {
+            id value = object[mname];
+            if (!value) {
+                // Relation not present on the object, so leave existing records unchanged.
+                continue;
+            }
+            [sourceRow removeObjectForKey:mname];
+            SCDBORMMapping *mapping = _mappings[mname];
+            NSString *mtable = mapping.table;
+            if ([mapping isObjectMapping]) {
+                if ([value isKindOfClass:[NSDictionary class]]) {
+                    // The related record shares the source object's ID.
+                    NSString *midColumn = [self columnWithName:mapping.idColumn orWithTag:@"id" onTable:mtable];
+                    NSMutableDictionary *row = [value mutableCopy];
+                    row[midColumn] = sid;
+                    [self addRow:row forTable:mtable to:objectRows];
+                }
+            }
+            else if ([mapping isSharedObjectMapping]) {
+                if ([value isKindOfClass:[NSDictionary class]]) {
+                    // The source record refers to the related record by its ID.
+                    NSString *midColumn = [self columnWithName:mapping.idColumn orWithTag:@"id" onTable:mtable];
+                    id mid = value[midColumn];
+                    if (mid) {
+                        [self addRow:value forTable:mtable to:sharedRows];
+                        sourceRow[mname] = mid;
+                    }
+                    else {
+                        [Logger warn:@"Unable to save %@.%@ value without an ID", _source, mname];
+                    }
+                }
+            }
+            else {
+                NSArray *members = [self membersOfCollection:value mapping:mapping ownerID:sid];
+                NSString *oidColumn = [self columnWithName:mapping.owneridColumn orWithTag:@"ownerid" onTable:mtable];
+                NSString *midColumn = [self columnWithName:mapping.idColumn orWithTag:@"id" onTable:mtable];
+                // Delete existing members not in the saved collection; if any member lacks an ID, or
+                // there are too many members for a single NOT IN list, then delete all existing members.
+                NSMutableArray *params = [[NSMutableArray alloc] initWithObjects:sid, nil];
+                for (NSDictionary *member in members) {
+                    id mid = member[midColumn];
+                    if (!mid || [params count] > SCSqliteINListChunkSize) {
+                        params = [[NSMutableArray alloc] initWithObjects:sid, nil];
+                        break;
+                    }
+                    [params addObject:mid];
+                }
+                NSString *sql;
+                if ([params count] > 1) {
+                    // Pad the list by repeating the last ID, so that the statement is reused for similar sizes.
+                    NSUInteger size = [SCSqliteDB INListSizeForCount:[params count] - 1];
+                    while ([params count] - 1 < size) {
+                        [params addObject:[params lastObject]];
+                    }
+                    NSString *placeholders = [[NSArray arrayWithItem:@"?" repeated:size] componentsJoinedByString:@","];
+                    sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@=? AND %@ NOT IN (%@)", mtable, oidColumn, midColumn, placeholders];
+                }
+                else {
+                    sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@=?", mtable, oidColumn];
+                }
+                [deletes addObject:@[ sql, params ]];
+                for (NSDictionary *member in members) {
+                    [self addRow:member forTable:mtable to:memberRows];
+                }
+            }
+        }
+        [sourceRows addObject:sourceRow];
+    }
+    // Write all rows.
+    BOOL ok = [_db beginTransaction];
+    if (ok) {
+        ok &= [self upsertTableRows:sharedRows];
+        ok = ok && [_db upsertValueList:sourceRows intoTable:_source];
+        ok = ok && [self upsertTableRows:objectRows];
+        for (NSArray *delete in deletes) {
+            ok = ok && [_db performUpdate:delete[0] withParams:delete[1]];
+        }
+        ok = ok && [self upsertTableRows:memberRows];
+        if (ok) {
+            ok = [_db commitTransaction];
+        }
+        else {
+            [_db rollbackTransaction];
+        }
+    }
+    return ok;
+}
+
+- (BOOL)deleteKey:(NSString *)key {
+    BOOL ok = YES;
+    [_db beginTransaction];
+    NSString *sql;
+    for (NSString *mname in [_mappings keyEnumerator]) {
+        SCDBORMMapping *mapping = _mappings[mname];
+        if ([@"map" isEqualToString:mapping.relation] ||
+            [@"dictionary" isEqualToString:mapping.relation] ||
+            [@"array" isEqualToString:mapping.relation] ||
+            [@"list" isEqualToString:mapping.relation]) {
+            
+            NSString *oidColumn = [self columnWithName:mapping.owneridColumn orWithTag:@"ownerid" onTable:mapping.table];
+            sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@=?", mapping.table, oidColumn];
+            ok &= [_db performUpdate:sql withParams:@[ key ]];
+        }
+    }
+    // The name of the ID column on the source table.
+    NSString *sidColumn = [self idColumnForTable:_source];
+    // TODO Support deletion of many-one relations by deleting records from relation table where no foreign key value in source table.
+    sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@=?", _source, sidColumn];
+    ok &= [_db performUpdate:sql withParams:@[ key ]];
+    if (ok) {
+        [_db commitTransaction];
+    }
+    else {
+        [_db rollbackTransaction];
+    }
+    return ok;
+}
+
+#pragma mark - Private methods and functions
+
+- (void)setSource:(NSString *)source {
+    _source = source;
+    [self clearSelectCache];
+}
+
+- (void)setMappings:(NSDictionary *)mappings {
+    _mappings = mappings;
+    [self clearSelectCache];
+}
+
+- (void)setCollectionStrategy:(SCDBORMCollectionStrategy)collectionStrategy {
+    _collectionStrategy = collectionStrategy;
+    [self clearSelectCache];
+}
+
+- (void)setDb:(SCDB *)db {
+    _db = db;
+    [self clearSelectCache];
+}
+
+- (void)clearSelectCache {
+    @synchronized (self) {
+        _selectCache = nil;
+    }
+}
+
+- (SCDBORMSelect *)selectWhere:(NSString *)where mappings:(NSArray *)mappings orderBy:(NSString *)orderBy {
+    // Only the mappings named in the list, and not their order, affect the generated SQL.
+    NSMutableArray *mappingNames = [NSMutableArray new];
+    for (NSString *mname in mappings) {
+        if (_mappings[mname] && ![mappingNames containsObject:mname]) {
+            [mappingNames addObject:mname];
+        }
+    }
+    [mappingNames sortUsingSelector:@selector(compare:)];
+    NSString *cacheKey = [NSString stringWithFormat:@"%@|%@|%@", [mappingNames componentsJoinedByString:@","], where, orderBy ?: @""];
+    SCDBORMSelect *select;
+    @synchronized (self) {
+        select = _selectCache[cacheKey];
+    }
+    if (!select) {
+        select = [self compileSelectWhere:where mappingNames:mappingNames orderBy:orderBy];
+        @synchronized (self) {
+            if (!_selectCache || [_selectCache count] >= SelectCacheSize) {
+                _selectCache = [NSMutableDictionary new];
+            }
+            _selectCache[cacheKey] = select;
+        }
+    }
+    return select;
+}
+
+- (void)loadCollection:(SCDBORMCollectionQuery *)query forObjects:(NSArray *)objects withIDColumn:(NSString *)idColumn {
+    // Index objects by ID. Keys are compared as strings, so that e.g. numeric owner IDs match text object IDs,
+    // as they would in a join.
+    NSMutableDictionary *objectsByID = [NSMutableDictionary new];
+    NSMutableArray *ids = [NSMutableArray new];
+    for (NSMutableDictionary *obj in objects) {
+        id objID = obj[idColumn];
+        if (objID) {
+            objectsByID[[objID description]] = obj;
+            [ids addObject:objID];
+        }
+    }
+    NSString *rname = query->_name;
+    NSArray *propertyNames = query->_propertyNames;
+    NSInteger columnCount = [propertyNames count];
+    NSInteger ownerColumnIndex = query->_ownerColumnIndex;
+    // Owner IDs are queried in chunks; each owner's members are in a single chunk, and so are ordered.
+    [_db enumerateQuery:query->_sql params:nil inList:ids usingResultSetBlock:^(SCSqliteResultSet *rs, BOOL *stop) {
+        NSMutableDictionary *obj = objectsByID[[[rs columnValue:ownerColumnIndex] description]];
+        if (!obj) {
+            return;
+        }
+        NSMutableDictionary *member = [NSMutableDictionary new];
+        for (NSInteger cidx = 0; cidx < columnCount; cidx++) {
+            if (![rs isColumnValueNull:cidx]) {
+                member[propertyNames[cidx]] = [rs columnValue:cidx];
+            }
+        }
+        NSMutableArray *members = obj[rname];
+        if (!members) {
+            members = [NSMutableArray new];
+            obj[rname] = members;
+        }
+        [members addObject:member];
+    }];
+}
+
+- (SCDBORMSelect *)compileSelectWhere:(NSString *)where mappingNames:(NSArray *)mappingNames orderBy:(NSString *)orderBy {
+    
     // The name of the ID column on the source table.
     NSString *sidColumn = [self idColumnForTable:_source];
     
@@ -48,69 +493,102 @@
     NSMutableArray *columns = [NSMutableArray new];     // Array of column name lists for source table and all joins.
     NSMutableArray *joins = [NSMutableArray new];       // Array of join SQL.
     NSMutableArray *orderBys = [NSMutableArray new];    // Array of order by column names.
-    NSMutableArray *collectionJoins = [NSMutableArray new];  // Array of collection relation names.
+    // Names, collection flags and column start indexes of each group of result columns.
+    NSMutableArray *groupNames = [NSMutableArray new];
+    NSMutableArray *groupIsCollection = [NSMutableArray new];
+    NSMutableArray *groupStarts = [NSMutableArray new];
+    // The property name of each result column.
+    NSMutableArray *propertyNames = [NSMutableArray new];
     
-    [columns addObject:[self columnNamesForTable:_source withPrefix:_source]];
+    [groupNames addObject:_source];
+    [groupIsCollection addObject:@NO];
+    [groupStarts addObject:@0];
+    [columns addObject:[self columnNamesForTable:_source withPrefix:_source propertyNames:propertyNames]];
+    NSInteger keyColumnIndex = [propertyNames indexOfObject:sidColumn];
+    NSMutableArray *collectionQueries = [NSMutableArray new];
     
-    for (NSString *mname in [_mappings keyEnumerator]) {
-        
-        // Skip the mapping if its name isn't in the list of mappings to include.
-        if (![mappings containsObject:mname]) {
-            continue;
-        }
+    for (NSString *mname in mappingNames) {
         
         SCDBORMMapping *mapping = _mappings[mname];
         NSString *mtable = mapping.table;
+        NSString *join = nil;
+        BOOL isCollection = NO;
 
         if ([@"object" isEqualToString:mapping.relation] ||
             [@"property" isEqualToString:mapping.relation]) {
 
-            [columns addObject:[self columnNamesForTable:mapping.table withPrefix:mname]];
             NSString *midColumn = [self columnWithName:mapping.idColumn orWithTag:@"id" onTable:mtable];
-            NSString *join = [NSString stringWithFormat:@"LEFT OUTER JOIN %@ %@ ON %@.%@=%@.%@",
-                              mtable,
-                              mname,
-                              mname,
-                              midColumn,
-                              _source,
-                              sidColumn];
-            [joins addObject:join];
+            join = [NSString stringWithFormat:@"LEFT OUTER JOIN %@ %@ ON %@.%@=%@.%@",
+                    mtable,
+                    mname,
+                    mname,
+                    midColumn,
+                    _source,
+                    sidColumn];
         }
         else if ([@"shared-object" isEqualToString:mapping.relation] ||
                  [@"shared-property" isEqualToString:mapping.relation]) {
 
-            [columns addObject:[self columnNamesForTable:mapping.table withPrefix:mname]];
             NSString *midColumn = [self columnWithName:mapping.idColumn orWithTag:@"id" onTable:mtable];
-            NSString *join = [NSString stringWithFormat:@"LEFT OUTER JOIN %@ %@ ON %@.%@=%@.%@",
-                              mtable,
-                              mname,
-                              _source,
-                              mname,
-                              mname,
-                              midColumn];
-            [joins addObject:join];
+            join = [NSString stringWithFormat:@"LEFT OUTER JOIN %@ %@ ON %@.%@=%@.%@",
+                    mtable,
+                    mname,
+                    _source,
+                    mname,
+                    mname,
+                    midColumn];
         }
         else if ([@"map" isEqualToString:mapping.relation] ||
                  [@"dictionary" isEqualToString:mapping.relation] ||
                  [@"array" isEqualToString:mapping.relation] ||
                  [@"list" isEqualToString:mapping.relation]) {
 
-            [columns addObject:[self columnNamesForTable:mapping.table withPrefix:mname]];
             NSString *oidColumn = [self columnWithName:mapping.owneridColumn orWithTag:@"ownerid" onTable:mtable];
-            NSString *join = [NSString stringWithFormat:@"LEFT OUTER JOIN %@ %@ ON %@.%@=%@.%@",
-                              mtable,
-                              mname,
-                              _source,
-                              sidColumn,
-                              mname,
-                              oidColumn];
-            [joins addObject:join];
-            [collectionJoins addObject:mname];
+            NSString *idxColumn = [self columnWithName:mapping.indexColumn orWithTag:@"key" onTable:mtable];
+            NSMutableArray *memberPropertyNames = [NSMutableArray new];
+            NSString *memberColumns = [self columnNamesForTable:mtable withPrefix:mname propertyNames:memberPropertyNames];
+            NSInteger ownerColumnIndex = [memberPropertyNames indexOfObject:oidColumn];
+            if (_collectionStrategy == SCDBORMCollectionStrategyBatched && ownerColumnIndex == NSNotFound) {
+                // Members can't be matched to their owners without the owner ID in the result, so join instead.
+                [Logger warn:@"Owner ID column %@ not found on table %@; loading relation %@ using a join", oidColumn, mtable, mname];
+            }
+            else if (_collectionStrategy == SCDBORMCollectionStrategyBatched) {
+                // Compile a separate query for the relation's members, ordered by the index column.
+                SCDBORMCollectionQuery *query = [SCDBORMCollectionQuery new];
+                query->_name = mname;
+                query->_propertyNames = memberPropertyNames;
+                query->_ownerColumnIndex = ownerColumnIndex;
+                query->_sql = [NSString stringWithFormat:@"SELECT %@ FROM %@ %@ WHERE %@.%@ IN %@ ORDER BY %@.%@",
+                               memberColumns,
+                               mtable,
+                               mname,
+                               mname,
+                               oidColumn,
+                               SCSqliteINListMarker,
+                               mname,
+                               idxColumn];
+                [collectionQueries addObject:query];
+                continue;
+            }
+            join = [NSString stringWithFormat:@"LEFT OUTER JOIN %@ %@ ON %@.%@=%@.%@",
+                    mtable,
+                    mname,
+                    _source,
+                    sidColumn,
+                    mname,
+                    oidColumn];
+            isCollection = YES;
             // Order the result by the index column; note that this will be empty for map/dictionary sets (i.e.
             // unordered collections), but will have values for array/list items.
-            NSString *idxColumn = [self columnWithName:mapping.indexColumn orWithTag:@"key" onTable:mtable];
             [orderBys addObject:[NSString stringWithFormat:@"%@.%@", mname, idxColumn]];
         }
+        if (join) {
+            [groupNames addObject:mname];
+            [groupIsCollection addObject:[NSNumber numberWithBool:isCollection]];
+            [groupStarts addObject:[NSNumber numberWithUnsignedInteger:[propertyNames count]]];
+            [columns addObject:[self columnNamesForTable:mtable withPrefix:mname propertyNames:propertyNames]];
+            [joins addObject:join];
+        }
     }
     // Generate select SQL.
     NSString *sql = [NSString stringWithFormat:@"SELECT %@ FROM %@ %@ %@ WHERE %@",
@@ -128,106 +606,24 @@
         sql = [sql stringByAppendingString:[orderBys componentsJoinedByString:@","]];
     }
     
-    // Execute the query and generate the result.
-    NSArray *rs = [_db performQuery:sql withParams:values];
-    NSMutableArray *result = [NSMutableArray new];
-    // The fully qualified name of the source object key column in the result set.
-    NSString *keyColumn = [NSString stringWithFormat:@"%@.%@", _source, sidColumn];
-    // The object currently being processed.
-    NSMutableDictionary *obj = nil;
-    for (NSDictionary *row in rs) {
-        id key = row[keyColumn]; // Read the key value from the current result set row.
-        // Convert flat result set row into groups of properties sharing the same column name prefix.
-        NSMutableDictionary *groups = [NSMutableDictionary new];
-        for (NSString *cname in [row keyEnumerator]) {
-            id value = row[cname];
-            // Only map columns with values.
-            if (value != nil) {
-                // Split column name into prefix/suffix parts.
-                NSRange range = [cname rangeOfString:@"."];
-                NSString *prefix = [cname substringToIndex:range.location];
-                NSString *suffix = [cname substringFromIndex:range.location + 1];
-                // Ensure that we have a dictionary for the prefix group.
-                NSMutableDictionary *group = groups[prefix];
-                if (!group) {
-                    group = [NSMutableDictionary new];
-                    groups[prefix] = group;
-                }
-                // Map the value to the suffix name within the group.
-                group[suffix] = value;
-            }
-        }
-        // Check if dealing with a new object.
-        if (obj == nil || ![obj[sidColumn] isEqual:key]) {
-            // Convert groups into object + properties.
-            obj = groups[_source];
-            for (NSString *rname in [groups keyEnumerator]) {
-                id value = groups[rname];
-                if (![rname isEqualToString:_source]) {
-                    // If relation name is for an outer join - i.e. a one to many - then init
-                    // the object property as an array of values.
-                    if ([collectionJoins containsObject:rname]) {
-                        obj[rname] = [[NSMutableArray alloc] initWithObjects:value, nil];
-                    }
-                    else {
-                        // Else map the object property name to the value.
-                        obj[rname] = value;
-                    }
-                }
-            }
-            [result addObject:obj];
-        }
-        else for (NSString *rname in collectionJoins) {
-            // Processing subsequent rows for the same object - indicates outer join results.
-            NSMutableArray *values = obj[rname];
-            if (!values) {
-                // Ensure that we have a list to hold the additional values.
-                values = [NSMutableArray new];
-                obj[rname] = values;
-            }
-            // If we have a value for the current relation group then add to the property value list.
-            id value = groups[rname];
-            if (value) {
-                [values addObject:value];
-            }
-        }
+    SCDBORMSelect *select = [SCDBORMSelect new];
+    select->_sql = sql;
+    select->_groupNames = groupNames;
+    select->_propertyNames = propertyNames;
+    select->_keyColumnIndex = keyColumnIndex;
+    select->_collectionQueries = collectionQueries;
+    select->_groupCount = [groupNames count];
+    select->_groupStarts = malloc(sizeof(NSInteger) * (select->_groupCount + 1));
+    select->_groupIsCollection = malloc(sizeof(BOOL) * select->_groupCount);
+    for (NSInteger gidx = 0; gidx < select->_groupCount; gidx++) {
+        select->_groupStarts[gidx] = [groupStarts[gidx] integerValue];
+        select->_groupIsCollection[gidx] = [groupIsCollection[gidx] boolValue];
     }
-    return result;
+    select->_groupStarts[select->_groupCount] = [propertyNames count];
+    return select;
 }
 
-- (BOOL)deleteKey:(NSString *)key {
-    BOOL ok = YES;
-    [_db beginTransaction];
-    NSString *sql;
-    for (NSString *mname in [_mappings keyEnumerator]) {
-        SCDBORMMapping *mapping = _mappings[mname];
-        if ([@"map" isEqualToString:mapping.relation] ||
-            [@"dictionary" isEqualToString:mapping.relation] ||
-            [@"array" isEqualToString:mapping.relation] ||
-            [@"list" isEqualToString:mapping.relation]) {
-            
-            NSString *oidColumn = [self columnWithName:mapping.owneridColumn orWithTag:@"ownerid" onTable:mapping.table];
-            sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@=?", mapping.table, oidColumn];
-            ok &= [_db performUpdate:sql withParams:@[ key ]];
-        }
-    }
-    // The name of the ID column on the source table.
-    NSString *sidColumn = [self idColumnForTable:_source];
-    // TODO Support deletion of many-one relations by deleting records from relation table where no foreign key value in source table.
-    sql = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@=?", _source, sidColumn];
-    ok &= [_db performUpdate:sql withParams:@[ key ]];
-    if (ok) {
-        [_db commitTransaction];
-    }
-    else {
-        [_db rollbackTransaction];
-    }
-    return ok;
-}
-
-#pragma mark - Private methods and functions
-
-- (NSString *)columnNamesForTable:(NSString *)table withPrefix:(NSString *)prefix {
+- (NSString *)columnNamesForTable:(NSString *)table withPrefix:(NSString *)prefix propertyNames:(NSMutableArray *)propertyNames {
     NSString *columnNames = nil;
     NSDictionary *tableDef = _db.tables[table];
     if (tableDef) {
@@ -236,6 +632,7 @@
         for (NSString *name in [columnDefs keyEnumerator]) {
             NSString *column = [NSString stringWithFormat:@"%@.%@", prefix, name];
             [columns addObject:[NSString stringWithFormat:@"%@ AS '%@'", column, column]];
+            [propertyNames addObject:name];
         }
         columnNames = [columns componentsJoinedByString:@","];
     }
@@ -256,6 +653,60 @@
     return name;
 }
 
+- (void)addRow:(NSDictionary *)row forTable:(NSString *)table to:(NSMutableDictionary *)tableRows {
+    NSMutableArray *rows = tableRows[table];
+    if (!rows) {
+        rows = [NSMutableArray new];
+        tableRows[table] = rows;
+    }
+    [rows addObject:row];
+}
+
+- (NSArray *)membersOfCollection:(id)collection mapping:(SCDBORMMapping *)mapping ownerID:(id)ownerID {
+    NSMutableArray *members = [NSMutableArray new];
+    NSString *mtable = mapping.table;
+    NSString *oidColumn = [self columnWithName:mapping.owneridColumn orWithTag:@"ownerid" onTable:mtable];
+    if ([collection isKindOfClass:[NSDictionary class]]) {
+        // A map of members keyed by name; the key is written to the key column.
+        NSString *keyColumn = [self columnWithName:mapping.keyColumn orWithTag:@"key" onTable:mtable];
+        for (id key in [collection keyEnumerator]) {
+            id value = collection[key];
+            if ([value isKindOfClass:[NSDictionary class]]) {
+                NSMutableDictionary *member = [value mutableCopy];
+                member[keyColumn] = key;
+                member[oidColumn] = ownerID;
+                [members addObject:member];
+            }
+        }
+    }
+    else if ([collection isKindOfClass:[NSArray class]]) {
+        // A list of members; list items without an index take their position in the list.
+        BOOL isList = [@"array" isEqualToString:mapping.relation] || [@"list" isEqualToString:mapping.relation];
+        NSString *idxColumn = [self columnWithName:mapping.indexColumn orWithTag:@"key" onTable:mtable];
+        NSInteger idx = 0;
+        for (id value in collection) {
+            if ([value isKindOfClass:[NSDictionary class]]) {
+                NSMutableDictionary *member = [value mutableCopy];
+                if (isList && !member[idxColumn]) {
+                    member[idxColumn] = [NSNumber numberWithInteger:idx];
+                }
+                member[oidColumn] = ownerID;
+                [members addObject:member];
+            }
+            idx++;
+        }
+    }
+    return members;
+}
+
+- (BOOL)upsertTableRows:(NSDictionary *)tableRows {
+    BOOL ok = YES;
+    for (NSString *table in [tableRows keyEnumerator]) {
+        ok &= [_db upsertValueList:tableRows[table] intoTable:table];
+    }
+    return ok;
+}
+
 #pragma mark - SCIOCTypeInspectable
 
 - (NSDictionary *)collectionMemberTypeInfo {
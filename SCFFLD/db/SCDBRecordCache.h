@@ -0,0 +1,82 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A bounded, least recently used cache of decoded database records.
+ * Records are cached per table, keyed by ID. Records derived from several tables (e.g. ORM object
+ * graphs) are cached in named views, which are cleared whenever any of the tables they depend on
+ * are invalidated.
+ * Each invalidation advances the cache's generation. Readers should note the generation before
+ * reading a record from the database, and pass it back when caching the record; a record read
+ * while an invalidation took place isn't cached, as it may already be out of date.
+ * Records are deep copied into immutable containers when cached, and cached records are shared between
+ * callers. Lookups and evictions take constant time. The cache is thread safe.
+ */
+@interface SCDBRecordCache : NSObject {
+    /// The cached records of each table or view, keyed by name.
+    NSMutableDictionary *_regions;
+    /// The maximum number of records cached for each table, keyed by table name.
+    NSDictionary *_tableSizes;
+    /// The names of the views depending on each table, keyed by table name.
+    NSMutableDictionary *_tableViews;
+    /// The current generation.
+    uint64_t _generation;
+    /// Cache statistics.
+    NSUInteger _hits;
+    NSUInteger _misses;
+    NSUInteger _evictions;
+}
+
+/**
+ * Initialize a cache.
+ * @param tableSizes    The maximum number of records to cache for each table, keyed by table name.
+ *                      Records are only cached for tables with a non-zero size.
+ * @param viewSize      The maximum number of records to cache for each view.
+ */
+- (id)initWithTableSizes:(NSDictionary *)tableSizes viewSize:(NSUInteger)viewSize;
+
+/// The maximum number of records cached for each view.
+@property (nonatomic, assign, readonly) NSUInteger viewSize;
+
+/// Test whether records are cached for a table.
+- (BOOL)cachesTable:(NSString *)table;
+/**
+ * Return a cached record.
+ * @param identifier    The record ID.
+ * @param name          A table or view name.
+ * @param generation    Set to the cache's current generation, for use when caching the record if not found.
+ */
+- (NSDictionary *)recordWithID:(id)identifier inTable:(NSString *)name generation:(uint64_t *)generation;
+/// Cache a table record read at the specified generation.
+- (void)setRecord:(NSDictionary *)record withID:(id)identifier inTable:(NSString *)table generation:(uint64_t)generation;
+/// Cache a view record, derived from the specified tables, read at the specified generation.
+- (void)setRecord:(NSDictionary *)record withID:(id)identifier inView:(NSString *)view dependingOnTables:(NSArray *)tables generation:(uint64_t)generation;
+/// Remove records with the specified IDs from a table, and clear views depending on the table.
+- (void)removeRecordsWithIDs:(NSArray *)identifiers fromTable:(NSString *)table;
+/// Remove all of a table's records, and clear views depending on the table.
+- (void)clearTable:(NSString *)table;
+/// Remove all records.
+- (void)clear;
+/**
+ * Return cache statistics.
+ * Returns the number of cached records (_size_), the cache _hits_, _misses_ and _evictions_, and the _hitRate_.
+ */
+- (NSDictionary *)statistics;
+
+@end
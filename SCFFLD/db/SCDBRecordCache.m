@@ -0,0 +1,340 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCDBRecordCache.h"
+
+/// Return a deep, immutable copy of a record value, so that cached records can't be modified through
+/// containers shared with the caller.
+static id SCDBRecordCacheImmutableCopy(id value) {
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *dictionary = (NSDictionary *)value;
+        NSMutableDictionary *result = [[NSMutableDictionary alloc] initWithCapacity:[dictionary count]];
+        for (id key in dictionary) {
+            result[key] = SCDBRecordCacheImmutableCopy(dictionary[key]);
+        }
+        return [result copy];
+    }
+    if ([value isKindOfClass:[NSArray class]]) {
+        NSMutableArray *result = [[NSMutableArray alloc] initWithCapacity:[(NSArray *)value count]];
+        for (id item in (NSArray *)value) {
+            [result addObject:SCDBRecordCacheImmutableCopy(item)];
+        }
+        return [result copy];
+    }
+    if ([value isKindOfClass:[NSSet class]]) {
+        NSMutableSet *result = [[NSMutableSet alloc] initWithCapacity:[(NSSet *)value count]];
+        for (id item in (NSSet *)value) {
+            [result addObject:SCDBRecordCacheImmutableCopy(item)];
+        }
+        return [result copy];
+    }
+    if ([value conformsToProtocol:@protocol(NSCopying)]) {
+        return [value copy];
+    }
+    return value;
+}
+
+/// A cached record; entries form a list in least to most recently used order.
+@interface SCDBRecordCacheEntry : NSObject {
+@public
+    /// The record's cache key.
+    NSString *_key;
+    /// The record.
+    NSDictionary *_record;
+    /// The previous (less recently used) entry.
+    __unsafe_unretained SCDBRecordCacheEntry *_prev;
+    /// The next (more recently used) entry; retains the rest of the list.
+    SCDBRecordCacheEntry *_next;
+}
+
+@end
+
+@implementation SCDBRecordCacheEntry
+
+@end
+
+/// The cached records of a table or view.
+@interface SCDBRecordCacheRegion : NSObject {
+@public
+    /// Cache entries, keyed by record ID.
+    NSMutableDictionary *_entries;
+    /// The least recently used entry.
+    SCDBRecordCacheEntry *_head;
+    /// The most recently used entry.
+    __unsafe_unretained SCDBRecordCacheEntry *_tail;
+    /// The maximum number of records in the region.
+    NSUInteger _size;
+}
+
+- (id)initWithSize:(NSUInteger)size;
+/// Remove an entry from the usage list.
+- (void)unlinkEntry:(SCDBRecordCacheEntry *)entry;
+/// Add an entry to the most recently used end of the usage list.
+- (void)appendEntry:(SCDBRecordCacheEntry *)entry;
+/// Mark an entry as the most recently used.
+- (void)touchEntry:(SCDBRecordCacheEntry *)entry;
+/// Remove the entry with the specified key.
+- (void)removeEntryWithKey:(NSString *)key;
+
+@end
+
+@implementation SCDBRecordCacheRegion
+
+- (id)initWithSize:(NSUInteger)size {
+    self = [super init];
+    if (self) {
+        _entries = [NSMutableDictionary new];
+        _size = size;
+    }
+    return self;
+}
+
+- (void)unlinkEntry:(SCDBRecordCacheEntry *)entry {
+    SCDBRecordCacheEntry *next = entry->_next;
+    if (entry->_prev) {
+        entry->_prev->_next = next;
+    }
+    else {
+        _head = next;
+    }
+    if (next) {
+        next->_prev = entry->_prev;
+    }
+    else {
+        _tail = entry->_prev;
+    }
+    entry->_prev = nil;
+    entry->_next = nil;
+}
+
+- (void)appendEntry:(SCDBRecordCacheEntry *)entry {
+    entry->_prev = _tail;
+    entry->_next = nil;
+    if (_tail) {
+        _tail->_next = entry;
+    }
+    else {
+        _head = entry;
+    }
+    _tail = entry;
+}
+
+- (void)touchEntry:(SCDBRecordCacheEntry *)entry {
+    if (entry != _tail) {
+        // Hold the entry while it's unlinked from the list.
+        SCDBRecordCacheEntry *retained = entry;
+        [self unlinkEntry:retained];
+        [self appendEntry:retained];
+    }
+}
+
+- (void)removeEntryWithKey:(NSString *)key {
+    SCDBRecordCacheEntry *entry = _entries[key];
+    if (entry) {
+        [self unlinkEntry:entry];
+        [_entries removeObjectForKey:key];
+    }
+}
+
+- (void)dealloc {
+    // Release the list iteratively; releasing the head could otherwise recurse through every entry.
+    SCDBRecordCacheEntry *entry = _head;
+    _head = nil;
+    while (entry) {
+        SCDBRecordCacheEntry *next = entry->_next;
+        entry->_next = nil;
+        entry = next;
+    }
+}
+
+@end
+
+@interface SCDBRecordCache ()
+
+/// Return the key used to cache a record ID; IDs are compared by their string form.
+- (NSString *)keyForID:(id)identifier;
+/// Add a record to a region. Call while synchronized.
+- (void)addRecord:(NSDictionary *)record withKey:(NSString *)key toRegion:(SCDBRecordCacheRegion *)region;
+/// Clear the views depending on a table. Call while synchronized.
+- (void)clearViewsOfTable:(NSString *)table;
+
+@end
+
+@implementation SCDBRecordCache
+
+- (id)initWithTableSizes:(NSDictionary *)tableSizes viewSize:(NSUInteger)viewSize {
+    self = [super init];
+    if (self) {
+        _regions = [NSMutableDictionary new];
+        _tableViews = [NSMutableDictionary new];
+        _tableSizes = tableSizes;
+        _viewSize = viewSize;
+    }
+    return self;
+}
+
+- (BOOL)cachesTable:(NSString *)table {
+    return [_tableSizes[table] unsignedIntegerValue] > 0;
+}
+
+- (NSDictionary *)recordWithID:(id)identifier inTable:(NSString *)name generation:(uint64_t *)generation {
+    NSString *key = [self keyForID:identifier];
+    @synchronized (self) {
+        *generation = _generation;
+        SCDBRecordCacheRegion *region = _regions[name];
+        SCDBRecordCacheEntry *entry = region ? region->_entries[key] : nil;
+        if (entry) {
+            _hits++;
+            [region touchEntry:entry];
+        }
+        else {
+            _misses++;
+        }
+        return entry ? entry->_record : nil;
+    }
+}
+
+- (void)setRecord:(NSDictionary *)record withID:(id)identifier inTable:(NSString *)table generation:(uint64_t)generation {
+    NSUInteger size = [_tableSizes[table] unsignedIntegerValue];
+    if (!record || size == 0) {
+        return;
+    }
+    NSString *key = [self keyForID:identifier];
+    record = SCDBRecordCacheImmutableCopy(record);
+    @synchronized (self) {
+        if (generation != _generation) {
+            // The record may have been invalidated while it was being read.
+            return;
+        }
+        SCDBRecordCacheRegion *region = _regions[table];
+        if (!region) {
+            region = [[SCDBRecordCacheRegion alloc] initWithSize:size];
+            _regions[table] = region;
+        }
+        [self addRecord:record withKey:key toRegion:region];
+    }
+}
+
+- (void)setRecord:(NSDictionary *)record withID:(id)identifier inView:(NSString *)view dependingOnTables:(NSArray *)tables generation:(uint64_t)generation {
+    if (!record || _viewSize == 0) {
+        return;
+    }
+    NSString *key = [self keyForID:identifier];
+    record = SCDBRecordCacheImmutableCopy(record);
+    @synchronized (self) {
+        if (generation != _generation) {
+            return;
+        }
+        SCDBRecordCacheRegion *region = _regions[view];
+        if (!region) {
+            region = [[SCDBRecordCacheRegion alloc] initWithSize:_viewSize];
+            _regions[view] = region;
+            for (NSString *table in tables) {
+                NSMutableSet *views = _tableViews[table];
+                if (!views) {
+                    views = [NSMutableSet new];
+                    _tableViews[table] = views;
+                }
+                [views addObject:view];
+            }
+        }
+        [self addRecord:record withKey:key toRegion:region];
+    }
+}
+
+- (void)removeRecordsWithIDs:(NSArray *)identifiers fromTable:(NSString *)table {
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:[identifiers count]];
+    for (id identifier in identifiers) {
+        [keys addObject:[self keyForID:identifier]];
+    }
+    @synchronized (self) {
+        _generation++;
+        SCDBRecordCacheRegion *region = _regions[table];
+        for (NSString *key in keys) {
+            [region removeEntryWithKey:key];
+        }
+        [self clearViewsOfTable:table];
+    }
+}
+
+- (void)clearTable:(NSString *)table {
+    @synchronized (self) {
+        _generation++;
+        [_regions removeObjectForKey:table];
+        [self clearViewsOfTable:table];
+    }
+}
+
+- (void)clear {
+    @synchronized (self) {
+        _generation++;
+        [_regions removeAllObjects];
+        [_tableViews removeAllObjects];
+    }
+}
+
+- (NSDictionary *)statistics {
+    @synchronized (self) {
+        NSUInteger size = 0;
+        for (NSString *name in _regions) {
+            size += [((SCDBRecordCacheRegion *)_regions[name])->_entries count];
+        }
+        NSUInteger lookups = _hits + _misses;
+        return @{
+            @"size":        [NSNumber numberWithUnsignedInteger:size],
+            @"hits":        [NSNumber numberWithUnsignedInteger:_hits],
+            @"misses":      [NSNumber numberWithUnsignedInteger:_misses],
+            @"evictions":   [NSNumber numberWithUnsignedInteger:_evictions],
+            @"hitRate":     [NSNumber numberWithDouble:(lookups > 0 ? (double)_hits / lookups : 0.0)]
+        };
+    }
+}
+
+#pragma mark - Private methods
+
+- (NSString *)keyForID:(id)identifier {
+    return [identifier isKindOfClass:[NSString class]] ? identifier : [identifier description];
+}
+
+- (void)addRecord:(NSDictionary *)record withKey:(NSString *)key toRegion:(SCDBRecordCacheRegion *)region {
+    SCDBRecordCacheEntry *entry = region->_entries[key];
+    if (entry) {
+        entry->_record = record;
+        [region touchEntry:entry];
+    }
+    else {
+        entry = [SCDBRecordCacheEntry new];
+        entry->_key = key;
+        entry->_record = record;
+        region->_entries[key] = entry;
+        [region appendEntry:entry];
+    }
+    // Evict the least recently used record(s) if the region is full.
+    while ([region->_entries count] > region->_size) {
+        [region removeEntryWithKey:region->_head->_key];
+        _evictions++;
+    }
+}
+
+- (void)clearViewsOfTable:(NSString *)table {
+    for (NSString *view in _tableViews[table]) {
+        [_regions removeObjectForKey:view];
+    }
+    [_tableViews removeObjectForKey:table];
+}
+
+@end
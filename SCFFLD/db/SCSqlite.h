@@ -18,9 +18,16 @@
 
 #import <Foundation/Foundation.h>
 #import "sqlite3.h"
+#import "SCSqliteProfiler.h"
+
+/// The marker in IN list statement SQL which is replaced with a parenthesized list of parameters.
+#define SCSqliteINListMarker    (@"(?*)")
+/// The maximum number of IN list values bound to each statement executed for an IN list.
+#define SCSqliteINListChunkSize (256)
 
 @class SCSqliteResultSet;
 @class SCSqlitePreparedStatement;
+@class SCSqliteBlob;
 
 /// A wrapper for an SQLite database.
 @interface SCSqliteDB : NSObject {
@@ -28,13 +35,33 @@
     NSString *_dbPath;
     /// The database handle.
     sqlite3 *_db;
+    /// Cached prepared statements, keyed by SQL.
+    NSMutableDictionary *_statementCache;
+    /// The SQL of cached statements, in least to most recently used order.
+    NSMutableOrderedSet *_statementCacheOrder;
+    /// Statement cache hit count.
+    NSUInteger _statementCacheHits;
+    /// Statement cache miss count.
+    NSUInteger _statementCacheMisses;
+    /// Statement cache eviction count.
+    NSUInteger _statementCacheEvictions;
 }
 
 /// A flag indicating that the database is open and available.
 @property (nonatomic, assign) BOOL open;
+/**
+ * The maximum number of prepared statements to cache on the connection.
+ * Statements are cached by SQL, and a cached statement is reset and reused when the same SQL
+ * is executed again. Set to zero to disable caching. Defaults to 32.
+ */
+@property (nonatomic, assign) NSUInteger statementCacheSize;
+/// An optional profiler; if set then all statements executed on the connection are profiled.
+@property (nonatomic, strong) SCSqliteProfiler *profiler;
 
 /// Connect to the database at the specified path.
 - (id)initWithDBPath:(NSString *)dbPath error:(NSError **)error;
+/// Open a connection to the database at the specified path, optionally as a read-only connection.
+- (id)initWithDBPath:(NSString *)dbPath readOnly:(BOOL)readOnly error:(NSError **)error;
 /// Prepare a SQL statement.
 - (SCSqlitePreparedStatement *)prepareStatement;
 /**
@@ -47,18 +74,67 @@
 - (SCSqliteResultSet *)executeQuery:(NSString *)sql error:(NSError **)error;
 /// Execute a query and return the result.
 - (SCSqliteResultSet *)executeQuery:(NSString *)sql parameters:(NSArray *)parameters error:(NSError **)error;
-/// Execute an update.
-- (void)executeUpdate:(NSString *)sql error:(NSError **)error;
-/// Execute an update.
-- (void)executeUpdate:(NSString *)sql parameters:(NSArray *)parameters error:(NSError **)error;
+/// Execute an update. Returns _NO_ if the update fails, and sets _error_.
+- (BOOL)executeUpdate:(NSString *)sql error:(NSError **)error;
+/// Execute an update. Returns _NO_ if the update fails, and sets _error_.
+- (BOOL)executeUpdate:(NSString *)sql parameters:(NSArray *)parameters error:(NSError **)error;
 /// Begin a database transaction.
-- (void)beginTransaction:(NSError **)error;
+- (BOOL)beginTransaction:(NSError **)error;
 /// Commit a database transaction.
-- (void)commitTransaction:(NSError **)error;
+- (BOOL)commitTransaction:(NSError **)error;
 /// Rollback the current database transaction.
-- (void)rollbackTransaction:(NSError **)error;
+- (BOOL)rollbackTransaction:(NSError **)error;
+/// Test whether the SQLite library supports INSERT ... ON CONFLICT DO UPDATE (i.e. is version 3.24 or later).
++ (BOOL)supportsUpsert;
+/// Test whether the FTS5 full-text search extension is available to the SQLite library.
++ (BOOL)supportsFTS5;
+/// Test whether a transaction is currently open on the connection.
+- (BOOL)inTransaction;
+/// Return the maximum number of parameters that can be bound to a single statement.
+- (NSInteger)maxParameterCount;
+/**
+ * Execute an update for a list of values of any length, e.g. to delete a large set of records by ID.
+ * The SQL's IN list marker (_(?*)_) is replaced with a list of parameters. The values are bound to the
+ * list in chunks of up to SCSqliteINListChunkSize values, after the statement's other parameters, and
+ * the statement is executed once for each chunk. The caller should open a transaction if the chunks
+ * need to be written atomically. Returns NO, without executing the statement, if the other parameters
+ * leave no room within the connection's parameter limit for any list values.
+ * Each chunk is padded to a size returned by INListSizeForCount:, so that lists of any length are
+ * executed using a few cached prepared statements.
+ */
+- (BOOL)executeUpdate:(NSString *)sql parameters:(NSArray *)parameters inList:(NSArray *)values error:(NSError **)error;
+/**
+ * Execute a query for a list of values of any length, and enumerate the result rows.
+ * The query is executed once for each chunk of the values; see executeUpdate:parameters:inList:error:.
+ * Note that any ORDER BY clause orders the rows of each chunk separately.
+ */
+- (BOOL)enumerateQuery:(NSString *)sql parameters:(NSArray *)parameters inList:(NSArray *)values usingBlock:(void (^)(SCSqliteResultSet *rs, BOOL *stop))block error:(NSError **)error;
+/**
+ * Return the number of parameters used for an IN list of values.
+ * Lists of up to SCSqliteINListChunkSize values are padded to the next power of two, by repeating the
+ * last value (which doesn't change the result of an IN or NOT IN operator), so that statements are
+ * reused; longer lists aren't padded.
+ */
++ (NSUInteger)INListSizeForCount:(NSUInteger)count;
+/**
+ * Open a blob for incremental I/O.
+ * @param table     The name of the table containing the blob.
+ * @param column    The name of the blob's column.
+ * @param rowID     The rowid of the blob's row.
+ * @param writable  If YES then the blob is opened for reading and writing; otherwise it is read-only.
+ */
+- (SCSqliteBlob *)openBlobInTable:(NSString *)table column:(NSString *)column rowID:(int64_t)rowID writable:(BOOL)writable error:(NSError **)error;
+/// Interrupt any operation currently running on the connection. Can be called from any thread.
+- (void)interrupt;
 /// Close the database connection.
 - (void)close;
+/// Finalize and remove all cached statements.
+- (void)clearStatementCache;
+/**
+ * Return statement cache statistics.
+ * Returns the number of cached statements (_size_), and the cache _hits_, _misses_ and _evictions_.
+ */
+- (NSDictionary *)statementCacheStatistics;
 
 @end
 
@@ -68,6 +144,8 @@
     SCSqlitePreparedStatement *_parent;
     /// The statement that generated this result set.
     sqlite3_stmt *_statement;
+    /// Flag indicating that the statement's execution is being profiled.
+    BOOL _profiled;
 }
 
 /// The number of columns in the result set.
@@ -81,12 +159,29 @@
 - (BOOL)done;
 /// Get a column name.
 - (NSString *)columnName:(NSInteger)columnIndex;
-/// Get a column value.
+/// Get the names of all result columns.
+- (NSArray *)columnNames;
+/// Get a column value. Blob values are returned as a copy of the blob data.
 - (id)columnValue:(NSInteger)columnIndex;
+/**
+ * Get a blob column value without copying it.
+ * The returned data references SQLite's own buffer, and is only valid until the result set is next
+ * stepped or closed; copy the data to keep it longer.
+ */
+- (NSData *)columnValueAsBlobNoCopy:(NSInteger)columnIndex;
 /// Get a column value as an integer.
 - (NSInteger)columnValueAsInteger:(NSInteger)columnIndex;
+/// Get a column value as a 64 bit integer, without boxing; null values are returned as zero.
+- (int64_t)columnValueAsInt64:(NSInteger)columnIndex;
+/// Get a column value as a double, without boxing; null values are returned as NaN.
+- (double)columnValueAsDouble:(NSInteger)columnIndex;
 /// Test whether a column has a null value.
 - (BOOL)isColumnValueNull:(NSInteger)columnIndex;
+/**
+ * Read the current row's non-null column values into a dictionary, keyed by column name.
+ * The dictionary isn't cleared first, so callers reusing a dictionary between rows should empty it.
+ */
+- (void)readRowInto:(NSMutableDictionary *)row;
 /// Close the result set.
 - (void)close;
 
@@ -100,14 +195,40 @@
     sqlite3_stmt *_statement;
     /// A statement compilation error.
     NSError *_compilationError;
+    /// An error binding the current parameter values, e.g. a blob too large for SQLite.
+    NSError *_bindingError;
+    /// The statement's result column names; read once, when first needed.
+    NSArray *_columnNames;
+    /// The statement's normalized SQL, used as its profile key.
+    NSString *_profileSQL;
+    /// Flag indicating that a profiled execution is in progress.
+    BOOL _profileExecuting;
+    /// The time spent stepping the statement in the current execution, in mach absolute time units.
+    uint64_t _profileStepTime;
+    /// The number of rows returned by the current execution.
+    NSUInteger _profileRows;
 }
 
 /// The number of parameters the statement accepts.
 @property (nonatomic, assign) NSInteger parameterCount;
 /// The statement's SQL.
 @property (nonatomic, strong) NSString *sql;
-/// The statement's parameter values.
+/**
+ * The statement's parameter values.
+ * Values may be strings, numbers, dates, data (bound as blobs), SCSqliteStaticData or SCSqliteZeroBlob
+ * instances; other values are bound as null. Data values are copied by SQLite when bound; wrap large,
+ * unchanging data in SCSqliteStaticData to bind it without a copy.
+ */
 @property (nonatomic, strong) NSArray *parameters;
+/**
+ * A flag indicating that the statement belongs to its connection's statement cache.
+ * Cached statements are reset, rather than finalized, when closed.
+ */
+@property (nonatomic, assign) BOOL cached;
+/// A flag indicating that a cached statement is currently being used.
+@property (nonatomic, assign) BOOL inUse;
+/// An optional profiler; must be set before the statement's SQL for prepare times to be recorded.
+@property (nonatomic, strong) SCSqliteProfiler *profiler;
 
 /// Initialize the statement.
 - (id)initWithDB:(sqlite3 *)db;
@@ -119,11 +240,72 @@
 - (SCSqliteResultSet *)executeQuery:(NSError **)error;
 /// Execute an update.
 - (BOOL)executeUpdate;
-/// Execute an update.
+/// Execute an update. Returns _NO_ if the statement can't be compiled or executed, and sets _error_.
 - (BOOL)executeUpdate:(NSError **)error;
 /// Reset the statement after use.
 - (void)reset;
-/// Close the statement.
+/// Close the statement. Cached statements are reset, other statements are finalized.
+- (void)close;
+/// Finalize the statement.
+- (void)finalizeStatement;
+/// The names of the statement's result columns.
+- (NSArray *)columnNames;
+
+@end
+
+/**
+ * A statement parameter value which binds data as a blob without copying it.
+ * The statement retains the wrapper for as long as it is bound, but the data's bytes are read by SQLite
+ * in place, so the data must not be mutated until the statement has been reset or its parameters replaced.
+ */
+@interface SCSqliteStaticData : NSObject
+
+/// Initialize with the data to bind.
+- (id)initWithData:(NSData *)data;
+
+/// The data to bind.
+@property (nonatomic, strong, readonly) NSData *data;
+
+@end
+
+/// A statement parameter value which binds a zero-filled blob, e.g. to reserve space for incremental blob writes.
+@interface SCSqliteZeroBlob : NSObject
+
+/// Initialize with the blob's length in bytes.
+- (id)initWithLength:(NSUInteger)length;
+
+/// The blob's length in bytes.
+@property (nonatomic, assign, readonly) NSUInteger length;
+
+@end
+
+/**
+ * A handle for incremental blob I/O.
+ * Allows large blobs to be read and written in chunks, without loading the whole blob into memory.
+ * A blob's size can't be changed through its handle; use SCSqliteZeroBlob to create a blob of the
+ * required size first. The handle becomes invalid if its row is modified other than through it.
+ */
+@interface SCSqliteBlob : NSObject {
+    /// The database.
+    sqlite3 *_db;
+    /// The blob handle.
+    sqlite3_blob *_blob;
+}
+
+/// The blob's length in bytes.
+@property (nonatomic, assign, readonly) NSUInteger length;
+
+/// Open a blob; see SCSqliteDB openBlobInTable:column:rowID:writable:error:.
+- (id)initWithDB:(sqlite3 *)db table:(NSString *)table column:(NSString *)column rowID:(int64_t)rowID writable:(BOOL)writable error:(NSError **)error;
+/// Read bytes from the blob into a buffer. Returns NO if the range is outside the blob.
+- (BOOL)readBytes:(void *)buffer length:(NSUInteger)length atOffset:(NSUInteger)offset error:(NSError **)error;
+/// Read a range of the blob; returns _nil_ if the range is outside the blob.
+- (NSData *)readDataOfLength:(NSUInteger)length atOffset:(NSUInteger)offset error:(NSError **)error;
+/// Write data to the blob. Returns NO if the data doesn't fit within the blob or the blob is read-only.
+- (BOOL)writeData:(NSData *)data atOffset:(NSUInteger)offset error:(NSError **)error;
+/// Move the handle to the same column of another row in the same table.
+- (BOOL)moveToRow:(int64_t)rowID error:(NSError **)error;
+/// Close the blob handle.
 - (void)close;
 
 @end
@@ -17,23 +17,75 @@
 //
 
 #import "SCSqlite.h"
+#import <mach/mach_time.h>
 
 #define SCSqliteBusyTimeout (30 * 1000)             // 30 seconds
 #define SCSqliteException   (@"SCSqliteException")
 #define SCSqliteError       (@"SCSqliteError")
 #define SCSqliteErrorCode   (0)
+#define SCSqliteDefaultStatementCacheSize   (32)
+
+/// Replace the IN list marker in SQL with a list of parameters.
+static NSString *SCSqliteSQLWithINList(NSString *sql, NSUInteger size) {
+    NSMutableString *list = [[NSMutableString alloc] initWithCapacity:size * 2 + 1];
+    [list appendString:@"("];
+    for (NSUInteger i = 0; i < size; i++) {
+        [list appendString:(i > 0 ? @",?" : @"?")];
+    }
+    [list appendString:@")"];
+    return [sql stringByReplacingOccurrencesOfString:SCSqliteINListMarker withString:list];
+}
+
+/// Return a statement's parameters followed by a chunk of IN list values, padded by repeating the last value.
+static NSArray *SCSqliteINListParameters(NSArray *parameters, NSArray *values, NSRange range, NSUInteger size) {
+    NSMutableArray *result = [[NSMutableArray alloc] initWithCapacity:[parameters count] + size];
+    if (parameters) {
+        [result addObjectsFromArray:parameters];
+    }
+    [result addObjectsFromArray:[values subarrayWithRange:range]];
+    id last = values[NSMaxRange(range) - 1];
+    for (NSUInteger i = range.length; i < size; i++) {
+        [result addObject:last];
+    }
+    return result;
+}
+
+@interface SCSqliteDB ()
+
+/**
+ * Return the number of IN list values to bind to each statement, given the number of other statement parameters.
+ * Returns zero, and sets _error_, if the other parameters leave no room for any IN list values.
+ */
+- (NSUInteger)INListChunkSizeWithParameterCount:(NSUInteger)parameterCount error:(NSError **)error;
+
+@end
+
+@interface SCSqlitePreparedStatement ()
+
+/// Record a step of a profiled execution of the statement.
+- (void)recordStepTime:(uint64_t)time row:(BOOL)row;
+
+@end
 
 @implementation SCSqliteDB
 
 - (id)initWithDBPath:(NSString *)dbPath error:(NSError *__autoreleasing *)error {
+    return [self initWithDBPath:dbPath readOnly:NO error:error];
+}
+
+- (id)initWithDBPath:(NSString *)dbPath readOnly:(BOOL)readOnly error:(NSError *__autoreleasing *)error {
     self = [super init];
     if (self) {
         _dbPath = dbPath;
+        _statementCache = [NSMutableDictionary new];
+        _statementCacheOrder = [NSMutableOrderedSet new];
+        _statementCacheSize = SCSqliteDefaultStatementCacheSize;
         BOOL ok = YES;
         NSString *errorMsg = nil;
         int err;
         if (ok) {
-            err = sqlite3_open([_dbPath fileSystemRepresentation], &_db);
+            int flags = readOnly ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+            err = sqlite3_open_v2([_dbPath fileSystemRepresentation], &_db, flags, NULL);
             if (err != SQLITE_OK) {
                 errorMsg = [NSString stringWithFormat:@"Error opening database: %s", sqlite3_errmsg(_db)];
                 ok = NO;
@@ -59,11 +111,61 @@
 }
 
 - (SCSqlitePreparedStatement *)prepareStatement {
-    return [[SCSqlitePreparedStatement alloc] initWithDB:_db];
+    SCSqlitePreparedStatement *statement = [[SCSqlitePreparedStatement alloc] initWithDB:_db];
+    statement.profiler = _profiler;
+    return statement;
 }
 
 - (SCSqlitePreparedStatement *)prepareStatement:(NSString *)sql parameters:(NSArray *)parameters {
-    return [[SCSqlitePreparedStatement alloc] initWithDB:_db sql:sql parameters:parameters];
+    if (sql && _statementCacheSize > 0) {
+        SCSqlitePreparedStatement *statement = _statementCache[sql];
+        if (statement && !statement.inUse) {
+            // Reuse the cached statement; it was reset when last closed, so only needs new parameters.
+            _statementCacheHits++;
+            [_statementCacheOrder removeObject:sql];
+            [_statementCacheOrder addObject:sql];
+            statement.inUse = YES;
+            statement.profiler = _profiler;
+            statement.parameters = parameters;
+            return statement;
+        }
+        if (!statement) {
+            _statementCacheMisses++;
+            statement = [[SCSqlitePreparedStatement alloc] initWithDB:_db];
+            statement.cached = YES;
+            statement.profiler = _profiler;
+            statement.sql = sql;
+            statement.parameters = parameters;
+            if (!statement.compilationError) {
+                statement.inUse = YES;
+                _statementCache[sql] = statement;
+                [_statementCacheOrder addObject:sql];
+                // Evict the least recently used statement(s) if the cache is full.
+                while ([_statementCacheOrder count] > _statementCacheSize) {
+                    NSString *evictedSQL = [_statementCacheOrder firstObject];
+                    SCSqlitePreparedStatement *evicted = _statementCache[evictedSQL];
+                    [_statementCacheOrder removeObjectAtIndex:0];
+                    [_statementCache removeObjectForKey:evictedSQL];
+                    // A statement still in use is finalized when closed.
+                    evicted.cached = NO;
+                    if (!evicted.inUse) {
+                        [evicted finalizeStatement];
+                    }
+                    _statementCacheEvictions++;
+                }
+            }
+            else {
+                statement.cached = NO;
+            }
+            return statement;
+        }
+        // Else the cached statement is in use (e.g. by an open result set) so use a new, uncached statement.
+    }
+    SCSqlitePreparedStatement *statement = [[SCSqlitePreparedStatement alloc] initWithDB:_db];
+    statement.profiler = _profiler;
+    statement.sql = sql;
+    statement.parameters = parameters;
+    return statement;
 }
 
 - (SCSqliteResultSet *)executeQuery:(NSString *)sql error:(NSError **)error {
@@ -75,29 +177,157 @@
     return [statement executeQuery:error];
 }
 
-- (void)executeUpdate:(NSString *)sql error:(NSError **)error {
-    [self executeUpdate:sql parameters:nil error:error];
+- (BOOL)executeUpdate:(NSString *)sql error:(NSError **)error {
+    return [self executeUpdate:sql parameters:nil error:error];
 }
 
-- (void)executeUpdate:(NSString *)sql parameters:(NSArray *)parameters error:(NSError **)error {
+- (BOOL)executeUpdate:(NSString *)sql parameters:(NSArray *)parameters error:(NSError **)error {
     SCSqlitePreparedStatement *statement = [self prepareStatement:sql parameters:parameters];
-    [statement executeUpdate:error];
+    return [statement executeUpdate:error];
+}
+
+- (BOOL)beginTransaction:(NSError **)error {
+    return [self executeUpdate:@"BEGIN DEFERRED" error:error];
+}
+
+- (BOOL)commitTransaction:(NSError **)error {
+    return [self executeUpdate:@"COMMIT" error:error];
 }
 
-- (void)beginTransaction:(NSError **)error {
-    [self executeUpdate:@"BEGIN DEFERRED" error:error];
+- (BOOL)rollbackTransaction:(NSError **)error {
+    return [self executeUpdate:@"ROLLBACK" error:error];
 }
 
-- (void)commitTransaction:(NSError **)error {
-    [self executeUpdate:@"COMMIT" error:error];
++ (BOOL)supportsUpsert {
+    return sqlite3_libversion_number() >= 3024000;
 }
 
-- (void)rollbackTransaction:(NSError **)error {
-    [self executeUpdate:@"ROLLBACK" error:error];
++ (BOOL)supportsFTS5 {
+    // The compile options don't cover FTS5 loaded as an extension, so probe by creating an FTS5 table
+    // in a scratch in-memory database.
+    static BOOL supported;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sqlite3 *db = NULL;
+        if (sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE, NULL) == SQLITE_OK) {
+            supported = sqlite3_exec(db, "CREATE VIRTUAL TABLE temp.x USING fts5(a)", NULL, NULL, NULL) == SQLITE_OK;
+        }
+        sqlite3_close(db);
+    });
+    return supported;
+}
+
+- (BOOL)inTransaction {
+    return _open && sqlite3_get_autocommit(_db) == 0;
+}
+
+- (NSInteger)maxParameterCount {
+    return _open ? sqlite3_limit(_db, SQLITE_LIMIT_VARIABLE_NUMBER, -1) : 0;
+}
+
+- (BOOL)executeUpdate:(NSString *)sql parameters:(NSArray *)parameters inList:(NSArray *)values error:(NSError **)error {
+    NSUInteger count = [values count];
+    NSUInteger chunkSize = [self INListChunkSizeWithParameterCount:[parameters count] error:error];
+    if (chunkSize == 0) {
+        return NO;
+    }
+    NSString *chunkSQL = nil;
+    NSUInteger chunkSQLSize = 0;
+    for (NSUInteger start = 0; start < count; start += chunkSize) {
+        NSUInteger length = MIN(chunkSize, count - start);
+        NSUInteger size = [SCSqliteDB INListSizeForCount:length];
+        if (size != chunkSQLSize) {
+            chunkSQL = SCSqliteSQLWithINList(sql, size);
+            chunkSQLSize = size;
+        }
+        if (![self executeUpdate:chunkSQL parameters:SCSqliteINListParameters(parameters, values, NSMakeRange(start, length), size) error:error]) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (BOOL)enumerateQuery:(NSString *)sql parameters:(NSArray *)parameters inList:(NSArray *)values usingBlock:(void (^)(SCSqliteResultSet *rs, BOOL *stop))block error:(NSError **)error {
+    NSUInteger count = [values count];
+    NSUInteger chunkSize = [self INListChunkSizeWithParameterCount:[parameters count] error:error];
+    if (chunkSize == 0) {
+        return NO;
+    }
+    NSString *chunkSQL = nil;
+    NSUInteger chunkSQLSize = 0;
+    BOOL stop = NO;
+    for (NSUInteger start = 0; start < count && !stop; start += chunkSize) {
+        NSUInteger length = MIN(chunkSize, count - start);
+        NSUInteger size = [SCSqliteDB INListSizeForCount:length];
+        if (size != chunkSQLSize) {
+            chunkSQL = SCSqliteSQLWithINList(sql, size);
+            chunkSQLSize = size;
+        }
+        NSError *chunkError = nil;
+        SCSqliteResultSet *rs = [self executeQuery:chunkSQL parameters:SCSqliteINListParameters(parameters, values, NSMakeRange(start, length), size) error:&chunkError];
+        if (chunkError) {
+            [rs close];
+            if (error) {
+                *error = chunkError;
+            }
+            return NO;
+        }
+        while (!stop && [rs next]) {
+            // Release each row's objects before reading the next.
+            @autoreleasepool {
+                block(rs, &stop);
+            }
+        }
+        [rs close];
+    }
+    return YES;
+}
+
++ (NSUInteger)INListSizeForCount:(NSUInteger)count {
+    if (count > SCSqliteINListChunkSize) {
+        return count;
+    }
+    NSUInteger size = 1;
+    while (size < count) {
+        size <<= 1;
+    }
+    return size;
+}
+
+- (NSUInteger)INListChunkSizeWithParameterCount:(NSUInteger)parameterCount error:(NSError **)error {
+    NSInteger maxParameterCount = [self maxParameterCount];
+    NSInteger available = maxParameterCount - (NSInteger)parameterCount;
+    if (available < 1) {
+        if (error) {
+            NSString *description = [NSString stringWithFormat:@"%lu parameters leave no room for IN list values within the limit of %ld",
+                                     (unsigned long)parameterCount, (long)maxParameterCount];
+            *error = [NSError errorWithDomain:SCSqliteError
+                                         code:SQLITE_RANGE
+                                     userInfo:@{ NSLocalizedDescriptionKey: description }];
+        }
+        return 0;
+    }
+    // Use the largest power of two which, with the other parameters, is within the parameter limit.
+    NSUInteger chunkSize = SCSqliteINListChunkSize;
+    while (chunkSize > 1 && (NSInteger)chunkSize > available) {
+        chunkSize >>= 1;
+    }
+    return chunkSize;
+}
+
+- (SCSqliteBlob *)openBlobInTable:(NSString *)table column:(NSString *)column rowID:(int64_t)rowID writable:(BOOL)writable error:(NSError **)error {
+    return [[SCSqliteBlob alloc] initWithDB:_db table:table column:column rowID:rowID writable:writable error:error];
+}
+
+- (void)interrupt {
+    if (_open) {
+        sqlite3_interrupt(_db);
+    }
 }
 
 - (void)close {
     if (_open) {
+        [self clearStatementCache];
         int error = sqlite3_close(_db);
         if (error == SQLITE_BUSY) {
             [NSException raise:SCSqliteException
@@ -111,6 +341,27 @@
     }
 }
 
+- (void)clearStatementCache {
+    for (NSString *sql in _statementCacheOrder) {
+        SCSqlitePreparedStatement *statement = _statementCache[sql];
+        statement.cached = NO;
+        if (!statement.inUse) {
+            [statement finalizeStatement];
+        }
+    }
+    [_statementCache removeAllObjects];
+    [_statementCacheOrder removeAllObjects];
+}
+
+- (NSDictionary *)statementCacheStatistics {
+    return @{
+        @"size":        [NSNumber numberWithUnsignedInteger:[_statementCache count]],
+        @"hits":        [NSNumber numberWithUnsignedInteger:_statementCacheHits],
+        @"misses":      [NSNumber numberWithUnsignedInteger:_statementCacheMisses],
+        @"evictions":   [NSNumber numberWithUnsignedInteger:_statementCacheEvictions]
+    };
+}
+
 @end
 
 @implementation SCSqliteResultSet
@@ -120,58 +371,130 @@
     if (self) {
         _parent = parent;
         _statement = statement;
+        _profiled = (parent.profiler != nil);
         self.columnCount = sqlite3_column_count(_statement);
     }
     return self;
 }
 
 - (BOOL)next {
+    if (_profiled) {
+        uint64_t start = mach_absolute_time();
+        int result = sqlite3_step(_statement);
+        [_parent recordStepTime:(mach_absolute_time() - start) row:(result == SQLITE_ROW)];
+        return (result == SQLITE_ROW);
+    }
     int result = sqlite3_step(_statement);
     return (result == SQLITE_ROW);
 }
 
 - (BOOL)done {
+    if (_profiled) {
+        uint64_t start = mach_absolute_time();
+        int result = sqlite3_step(_statement);
+        [_parent recordStepTime:(mach_absolute_time() - start) row:(result == SQLITE_ROW)];
+        return (result == SQLITE_DONE);
+    }
     int result = sqlite3_step(_statement);
     return (result == SQLITE_DONE);
 }
 
 - (NSString *)columnName:(NSInteger)columnIndex {
     if (columnIndex < _columnCount) {
-        return [NSString stringWithUTF8String:sqlite3_column_name(_statement, (int)columnIndex)];
+        return [_parent columnNames][columnIndex];
     }
     return nil;
 }
 
+- (NSArray *)columnNames {
+    return [_parent columnNames];
+}
+
 - (id)columnValue:(NSInteger)columnIndex {
     id value = nil;
     int _columnIdx = (int)columnIndex;
     int columnType = sqlite3_column_type(_statement, _columnIdx);
     switch (columnType) {
-    case SQLITE_TEXT:
-        value = [NSString stringWithCharacters:sqlite3_column_text16(_statement, _columnIdx)
-                                        length:sqlite3_column_bytes16(_statement, _columnIdx) / 2];
+    case SQLITE_TEXT: {
+        // Decode directly from SQLite's native UTF-8 representation. Note that sqlite3_column_bytes
+        // must be called after sqlite3_column_text.
+        const unsigned char *text = sqlite3_column_text(_statement, _columnIdx);
+        int length = sqlite3_column_bytes(_statement, _columnIdx);
+        value = [[NSString alloc] initWithBytes:text length:length encoding:NSUTF8StringEncoding];
+        if (!value) {
+            // The text isn't valid UTF-8; read it as UTF-16, which SQLite converts with replacement
+            // characters, so that the column isn't lost.
+            const void *text16 = sqlite3_column_text16(_statement, _columnIdx);
+            int length16 = sqlite3_column_bytes16(_statement, _columnIdx);
+            value = [[NSString alloc] initWithCharacters:text16 length:(length16 / sizeof(unichar))];
+        }
         break;
+    }
     case SQLITE_INTEGER:
         value = [NSNumber numberWithLongLong:sqlite3_column_int64(_statement, _columnIdx)];
         break;
     case SQLITE_FLOAT:
         value = [NSNumber numberWithDouble:sqlite3_column_double(_statement, _columnIdx)];
         break;
+    case SQLITE_BLOB: {
+        // As with text, sqlite3_column_bytes must be called after sqlite3_column_blob.
+        const void *bytes = sqlite3_column_blob(_statement, _columnIdx);
+        int length = sqlite3_column_bytes(_statement, _columnIdx);
+        value = [NSData dataWithBytes:bytes length:length];
+        break;
+    }
     case SQLITE_NULL:
         value = [NSNull null];
     }
     return value;
 }
 
+- (NSData *)columnValueAsBlobNoCopy:(NSInteger)columnIndex {
+    int _columnIdx = (int)columnIndex;
+    if (sqlite3_column_type(_statement, _columnIdx) == SQLITE_NULL) {
+        return nil;
+    }
+    const void *bytes = sqlite3_column_blob(_statement, _columnIdx);
+    int length = sqlite3_column_bytes(_statement, _columnIdx);
+    if (bytes == NULL) {
+        return [NSData data];
+    }
+    return [NSData dataWithBytesNoCopy:(void *)bytes length:length freeWhenDone:NO];
+}
+
 - (NSInteger)columnValueAsInteger:(NSInteger)columnIndex {
     id value = [self columnValue:columnIndex];
     return [value isKindOfClass:[NSNumber class]] ? [(NSNumber *)value integerValue] : 0;
 }
 
+- (int64_t)columnValueAsInt64:(NSInteger)columnIndex {
+    return sqlite3_column_int64(_statement, (int)columnIndex);
+}
+
+- (double)columnValueAsDouble:(NSInteger)columnIndex {
+    if (sqlite3_column_type(_statement, (int)columnIndex) == SQLITE_NULL) {
+        return NAN;
+    }
+    return sqlite3_column_double(_statement, (int)columnIndex);
+}
+
 - (BOOL)isColumnValueNull:(NSInteger)columnIndex {
     return sqlite3_column_type(_statement, (int)columnIndex) == SQLITE_NULL;
 }
 
+- (void)readRowInto:(NSMutableDictionary *)row {
+    NSArray *columnNames = [_parent columnNames];
+    NSInteger colCount = MIN(_columnCount, (NSInteger)[columnNames count]);
+    for (NSInteger idx = 0; idx < colCount; idx++) {
+        if (sqlite3_column_type(_statement, (int)idx) != SQLITE_NULL) {
+            id value = [self columnValue:idx];
+            if (value) {
+                row[columnNames[idx]] = value;
+            }
+        }
+    }
+}
+
 - (void)close {
     _statement = NULL;
     [_parent close];
@@ -181,7 +504,10 @@
 
 @interface SCSqlitePreparedStatement ()
 
+/// Bind the parameter values to the statement. Sets _bindingError if a value can't be bound.
 - (void)bindParameters;
+/// Return an error for a parameter value which can't be bound.
+- (NSError *)bindingErrorForParameter:(NSInteger)paramIdx reason:(NSString *)reason;
 
 @end
 
@@ -203,12 +529,27 @@
 
 - (void)setSql:(NSString *)sql {
     _sql = sql;
-    [self close];
+    _columnNames = nil;
+    _profileSQL = nil;
+    [self finalizeStatement];
     if (sql) {
         _parameterCount = 0;
         _compilationError = nil;
         const char *trailing;
-        int error = sqlite3_prepare_v2(_db, [sql UTF8String], -1, &_statement, &trailing);
+        int error;
+        uint64_t prepareStart = _profiler ? mach_absolute_time() : 0;
+#ifdef SQLITE_PREPARE_PERSISTENT
+        // Hint to SQLite that cached statements are long lived.
+        if (_cached && sqlite3_libversion_number() >= 3020000) {
+            error = sqlite3_prepare_v3(_db, [sql UTF8String], -1, SQLITE_PREPARE_PERSISTENT, &_statement, &trailing);
+        }
+        else
+#endif
+        error = sqlite3_prepare_v2(_db, [sql UTF8String], -1, &_statement, &trailing);
+        if (_profiler) {
+            _profileSQL = [_profiler normalizeSQL:sql];
+            [_profiler recordPrepareOfSQL:_profileSQL time:(mach_absolute_time() - prepareStart)];
+        }
         if (error != SQLITE_OK) {
             NSDictionary *userInfo = @{
                 NSLocalizedDescriptionKey:  [NSString stringWithUTF8String: sqlite3_errmsg(_db)],
@@ -231,6 +572,10 @@
 }
 
 - (void)setParameters:(NSArray *)parameters {
+    if (!parameters && _statement != NULL) {
+        // Clear bindings which may reference the previous parameter values.
+        sqlite3_clear_bindings(_statement);
+    }
     _parameters = parameters;
     self.parameterCount = (_parameters) ? [_parameters count] : 0;
     [self bindParameters];
@@ -242,12 +587,30 @@
 
 - (SCSqliteResultSet *)executeQuery:(NSError **)error {
     SCSqliteResultSet *rs = nil;
-    if (_compilationError) {
-        *error = _compilationError;
+    if (_compilationError || _bindingError) {
+        if (error) {
+            *error = _compilationError ? _compilationError : _bindingError;
+        }
+        // Nothing will close a statement which fails to execute, so release it now; this returns a cached
+        // statement to its cache, rather than leaving it in use.
+        [self close];
     }
     else if (_statement != NULL) {
+        if (_profiler) {
+            if (!_profileSQL) {
+                _profileSQL = [_profiler normalizeSQL:_sql];
+            }
+            _profileExecuting = YES;
+            _profileStepTime = 0;
+            _profileRows = 0;
+        }
         rs = [[SCSqliteResultSet alloc] initWithParent:self statement:_statement];
     }
+    else if (error) {
+        *error = [NSError errorWithDomain:SCSqliteError
+                                     code:SCSqliteErrorCode
+                                 userInfo:@{ NSLocalizedDescriptionKey: @"No SQL statement to execute" }];
+    }
     return rs;
 }
 
@@ -256,14 +619,20 @@
 }
 
 - (BOOL)executeUpdate:(NSError **)error {
-    BOOL ok = NO;
     SCSqliteResultSet *rs = [self executeQuery:error];
-    if (rs && !*error) {
-        if ([rs done]) {
-            ok = YES;
-        }
-        [rs close];
+    if (!rs) {
+        return NO;
+    }
+    BOOL ok = [rs done];
+    if (!ok && error) {
+        // Read the error before closing the result set, which resets the statement.
+        NSDictionary *userInfo = @{
+            NSLocalizedDescriptionKey:  [NSString stringWithUTF8String:sqlite3_errmsg(_db)],
+            @"SQL":                     _sql
+        };
+        *error = [NSError errorWithDomain:SCSqliteError code:sqlite3_errcode(_db) userInfo:userInfo];
     }
+    [rs close];
     return ok;
 }
 
@@ -272,15 +641,58 @@
 }
 
 - (void)close {
+    if (_profileExecuting) {
+        _profileExecuting = NO;
+        [_profiler recordExecutionOfSQL:_profileSQL stepTime:_profileStepTime rows:_profileRows sql:_sql db:_db];
+    }
+    if (_cached) {
+        // Reset the statement so that it is ready for reuse.
+        if (_statement != NULL) {
+            sqlite3_reset(_statement);
+            sqlite3_clear_bindings(_statement);
+        }
+        _inUse = NO;
+    }
+    else {
+        [self finalizeStatement];
+    }
+}
+
+- (void)finalizeStatement {
     if (_statement != NULL) {
         sqlite3_finalize(_statement);
         _statement = NULL;
     }
 }
 
+- (NSArray *)columnNames {
+    if (_statement == NULL) {
+        return @[];
+    }
+    int count = sqlite3_column_count(_statement);
+    // The column count can change if the statement is reprepared after a schema change.
+    if (!_columnNames || (NSInteger)[_columnNames count] != count) {
+        NSMutableArray *columnNames = [[NSMutableArray alloc] initWithCapacity:count];
+        for (int idx = 0; idx < count; idx++) {
+            NSString *name = [NSString stringWithUTF8String:sqlite3_column_name(_statement, idx)];
+            [columnNames addObject:name];
+        }
+        _columnNames = columnNames;
+    }
+    return _columnNames;
+}
+
+- (void)recordStepTime:(uint64_t)time row:(BOOL)row {
+    _profileStepTime += time;
+    if (row) {
+        _profileRows++;
+    }
+}
+
 #pragma mark - private
 
 - (void)bindParameters {
+    _bindingError = nil;
     if (_statement != NULL && _parameters) {
         NSInteger count = MIN([_parameters count], _parameterCount);
         for (NSInteger idx = 0; idx < count; idx++) {
@@ -308,6 +720,33 @@
             else if ([value isKindOfClass: [NSDate class]]) {
                 sqlite3_bind_double(_statement, paramIdx, [value timeIntervalSince1970]);
             }
+            else if ([value isKindOfClass: [NSData class]] || [value isKindOfClass: [SCSqliteStaticData class]]) {
+                // Data is copied by SQLite unless the caller has opted out of the copy by wrapping it.
+                BOOL isStatic = [value isKindOfClass: [SCSqliteStaticData class]];
+                NSData *data = isStatic ? [(SCSqliteStaticData *)value data] : (NSData *)value;
+                NSUInteger length = [data length];
+                if (length > INT_MAX) {
+                    sqlite3_bind_null(_statement, paramIdx);
+                    _bindingError = [self bindingErrorForParameter:paramIdx reason:@"Blob is too large to bind"];
+                }
+                else if (length == 0) {
+                    // Binding a zero length blob pointer would bind null.
+                    sqlite3_bind_zeroblob(_statement, paramIdx, 0);
+                }
+                else {
+                    sqlite3_bind_blob(_statement, paramIdx, [data bytes], (int)length, isStatic ? SQLITE_STATIC : SQLITE_TRANSIENT);
+                }
+            }
+            else if ([value isKindOfClass: [SCSqliteZeroBlob class]]) {
+                NSUInteger length = [(SCSqliteZeroBlob *)value length];
+                if (length > INT_MAX) {
+                    sqlite3_bind_null(_statement, paramIdx);
+                    _bindingError = [self bindingErrorForParameter:paramIdx reason:@"Zero blob is too large to bind"];
+                }
+                else {
+                    sqlite3_bind_zeroblob(_statement, paramIdx, (int)length);
+                }
+            }
             else {
                 // Bind null to non-convertable values.
                 sqlite3_bind_null(_statement, paramIdx);
@@ -316,4 +755,146 @@
     }
 }
 
+- (NSError *)bindingErrorForParameter:(NSInteger)paramIdx reason:(NSString *)reason {
+    NSDictionary *userInfo = @{
+        NSLocalizedDescriptionKey:  [NSString stringWithFormat:@"%@ (parameter %ld)", reason, (long)paramIdx],
+        @"SQL":                     _sql ? _sql : @""
+    };
+    return [NSError errorWithDomain:SCSqliteError code:SQLITE_TOOBIG userInfo:userInfo];
+}
+
+@end
+
+@implementation SCSqliteStaticData
+
+- (id)initWithData:(NSData *)data {
+    self = [super init];
+    if (self) {
+        _data = data;
+    }
+    return self;
+}
+
+@end
+
+@implementation SCSqliteZeroBlob
+
+- (id)initWithLength:(NSUInteger)length {
+    self = [super init];
+    if (self) {
+        _length = length;
+    }
+    return self;
+}
+
+@end
+
+@interface SCSqliteBlob ()
+
+/// Return an error for an SQLite result code.
+- (NSError *)errorWithCode:(int)code;
+
+@end
+
+@implementation SCSqliteBlob
+
+- (id)initWithDB:(sqlite3 *)db table:(NSString *)table column:(NSString *)column rowID:(int64_t)rowID writable:(BOOL)writable error:(NSError **)error {
+    self = [super init];
+    if (self) {
+        _db = db;
+        int result = sqlite3_blob_open(_db, "main", [table UTF8String], [column UTF8String], rowID, writable ? 1 : 0, &_blob);
+        if (result != SQLITE_OK) {
+            if (error) {
+                *error = [self errorWithCode:result];
+            }
+            return nil;
+        }
+        _length = sqlite3_blob_bytes(_blob);
+    }
+    return self;
+}
+
+- (BOOL)readBytes:(void *)buffer length:(NSUInteger)length atOffset:(NSUInteger)offset error:(NSError **)error {
+    int result = SQLITE_MISUSE;
+    if (length > INT_MAX || offset > INT_MAX) {
+        result = SQLITE_TOOBIG;
+    }
+    else if (_blob) {
+        result = sqlite3_blob_read(_blob, buffer, (int)length, (int)offset);
+    }
+    if (result != SQLITE_OK) {
+        if (error) {
+            *error = [self errorWithCode:result];
+        }
+        return NO;
+    }
+    return YES;
+}
+
+- (NSData *)readDataOfLength:(NSUInteger)length atOffset:(NSUInteger)offset error:(NSError **)error {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    if (![self readBytes:[data mutableBytes] length:length atOffset:offset error:error]) {
+        return nil;
+    }
+    return data;
+}
+
+- (BOOL)writeData:(NSData *)data atOffset:(NSUInteger)offset error:(NSError **)error {
+    int result = SQLITE_MISUSE;
+    if ([data length] > INT_MAX || offset > INT_MAX) {
+        result = SQLITE_TOOBIG;
+    }
+    else if (_blob) {
+        result = sqlite3_blob_write(_blob, [data bytes], (int)[data length], (int)offset);
+    }
+    if (result != SQLITE_OK) {
+        if (error) {
+            *error = [self errorWithCode:result];
+        }
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL)moveToRow:(int64_t)rowID error:(NSError **)error {
+    int result = _blob ? sqlite3_blob_reopen(_blob, rowID) : SQLITE_MISUSE;
+    if (result != SQLITE_OK) {
+        if (error) {
+            *error = [self errorWithCode:result];
+        }
+        return NO;
+    }
+    _length = sqlite3_blob_bytes(_blob);
+    return YES;
+}
+
+- (void)close {
+    if (_blob != NULL) {
+        sqlite3_blob_close(_blob);
+        _blob = NULL;
+    }
+}
+
+- (void)dealloc {
+    [self close];
+}
+
+#pragma mark - private
+
+- (NSError *)errorWithCode:(int)code {
+    NSString *message;
+    if (code == SQLITE_MISUSE) {
+        message = @"Blob handle is closed";
+    }
+    else if (code == SQLITE_TOOBIG) {
+        message = @"Blob range is too large";
+    }
+    else {
+        message = [NSString stringWithUTF8String:sqlite3_errmsg(_db)];
+    }
+    return [NSError errorWithDomain:SCSqliteError
+                               code:code
+                           userInfo:@{ NSLocalizedDescriptionKey: message }];
+}
+
 @end
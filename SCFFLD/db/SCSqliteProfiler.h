@@ -0,0 +1,70 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "sqlite3.h"
+
+/**
+ * A profiler of SQLite statement executions.
+ * When a profiler is assigned to a database connection, each statement execution on the connection
+ * is recorded against the statement's normalized SQL (i.e. with literal values replaced by ?, and
+ * parameter and VALUES lists collapsed), so that statements differing only in their values or list
+ * lengths are profiled together. Executions taking longer than the slow query threshold are logged,
+ * and the query plan of each slow statement is captured, with full table scans flagged.
+ * A profiler can be shared by several connections, and is thread safe.
+ */
+@interface SCSqliteProfiler : NSObject {
+    /// Profiles of executed statements, keyed by normalized SQL.
+    NSMutableDictionary *_profiles;
+    /// Recent slow statement executions, oldest first.
+    NSMutableArray *_slowQueries;
+    /// Normalized SQL, keyed by SQL.
+    NSMutableDictionary *_normalizedSQL;
+}
+
+/// The execution time, in seconds, above which a statement execution is logged as slow. Defaults to 0.1.
+@property (nonatomic, assign) NSTimeInterval slowQueryThreshold;
+/// The number of slow statement executions to keep in the slow query log. Defaults to 50.
+@property (nonatomic, assign) NSUInteger slowQueryLogSize;
+
+/// Return the normalized form of a statement's SQL.
+- (NSString *)normalizeSQL:(NSString *)sql;
+/// Record the time taken to prepare a statement; the time is in mach absolute time units.
+- (void)recordPrepareOfSQL:(NSString *)normalizedSQL time:(uint64_t)time;
+/**
+ * Record a statement execution.
+ * @param normalizedSQL The statement's normalized SQL.
+ * @param stepTime      The total time spent stepping the statement, in mach absolute time units.
+ * @param rows          The number of result rows returned.
+ * @param sql           The statement's SQL.
+ * @param db            The connection the statement was executed on; used to capture query plans.
+ */
+- (void)recordExecutionOfSQL:(NSString *)normalizedSQL stepTime:(uint64_t)stepTime rows:(NSUInteger)rows sql:(NSString *)sql db:(sqlite3 *)db;
+/**
+ * Return a snapshot of the profile.
+ * The snapshot's _statements_ dictionary contains, for each normalized SQL statement, the execution
+ * _count_, _totalTime_ and _maxTime_ (in seconds), _rows_ returned, _prepareCount_ and _prepareTime_;
+ * and, for slow statements, the query _plan_ and a _fullScan_ flag. The snapshot's _slowQueries_ list
+ * contains the _sql_, _time_, _rows_ and _timestamp_ of recent slow executions.
+ */
+- (NSDictionary *)snapshot;
+/// Return a snapshot of the profile as JSON data.
+- (NSData *)JSONData;
+/// Discard all recorded data.
+- (void)reset;
+
+@end
@@ -0,0 +1,323 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCSqliteProfiler.h"
+#import "SCLogger.h"
+#import <mach/mach_time.h>
+
+/// The maximum number of SQL strings whose normalized form is remembered.
+static const NSUInteger NormalizedSQLCacheSize = 1000;
+
+static SCLogger *Logger;
+
+/// Statistics for a single normalized statement.
+@interface SCSqliteStatementProfile : NSObject {
+@public
+    NSUInteger _count;
+    uint64_t _totalTime;
+    uint64_t _maxTime;
+    NSUInteger _rows;
+    NSUInteger _prepareCount;
+    uint64_t _prepareTime;
+    /// The statement's query plan; captured when the statement is first slow.
+    NSArray *_plan;
+    /// Flag indicating that the query plan contains a full table scan.
+    BOOL _fullScan;
+}
+
+@end
+
+@implementation SCSqliteStatementProfile
+
+@end
+
+@interface SCSqliteProfiler ()
+
+/// Return the profile for a normalized statement, creating it if necessary. Call while synchronized.
+- (SCSqliteStatementProfile *)profileForSQL:(NSString *)normalizedSQL;
+/// Read the query plan of a statement.
+- (NSArray *)queryPlanForSQL:(NSString *)sql db:(sqlite3 *)db;
+/// Test whether a query plan contains a full scan of a stored table.
+- (BOOL)planHasFullTableScan:(NSArray *)plan sql:(NSString *)sql;
+/// Return the lowercase names of CTEs and subqueries (and their aliases) referenced by a statement.
+- (NSSet *)derivedTableNamesInPlan:(NSArray *)plan sql:(NSString *)sql;
+/// Convert a mach absolute time interval to seconds.
+- (NSTimeInterval)secondsFromMachTime:(uint64_t)time;
+
+@end
+
+@implementation SCSqliteProfiler
+
++ (void)initialize {
+    Logger = [[SCLogger alloc] initWithTag:@"SCSqliteProfiler"];
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _profiles = [NSMutableDictionary new];
+        _slowQueries = [NSMutableArray new];
+        _normalizedSQL = [NSMutableDictionary new];
+        _slowQueryThreshold = 0.1;
+        _slowQueryLogSize = 50;
+    }
+    return self;
+}
+
+- (NSString *)normalizeSQL:(NSString *)sql {
+    if (!sql) {
+        return nil;
+    }
+    @synchronized (self) {
+        NSString *normalized = _normalizedSQL[sql];
+        if (normalized) {
+            return normalized;
+        }
+    }
+    static NSArray *Patterns;
+    static NSArray *Templates;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        Patterns = @[
+            // String literals.
+            [NSRegularExpression regularExpressionWithPattern:@"'(?:[^']|'')*'" options:0 error:nil],
+            // Numeric literals.
+            [NSRegularExpression regularExpressionWithPattern:@"\\b\\d+(?:\\.\\d+)?\\b" options:0 error:nil],
+            // Whitespace.
+            [NSRegularExpression regularExpressionWithPattern:@"\\s+" options:0 error:nil],
+            // Parameter lists.
+            [NSRegularExpression regularExpressionWithPattern:@"\\?(?: ?, ?\\?)+" options:0 error:nil],
+            // Repeated VALUES rows.
+            [NSRegularExpression regularExpressionWithPattern:@"(\\([^()]*\\))(?: ?, ?\\1)+" options:0 error:nil]
+        ];
+        Templates = @[ @"?", @"?", @" ", @"?,...", @"$1,..." ];
+    });
+    NSMutableString *normalized = [sql mutableCopy];
+    for (NSUInteger i = 0; i < [Patterns count]; i++) {
+        [Patterns[i] replaceMatchesInString:normalized options:0 range:NSMakeRange(0, [normalized length]) withTemplate:Templates[i]];
+    }
+    NSString *result = [normalized stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+    @synchronized (self) {
+        if ([_normalizedSQL count] >= NormalizedSQLCacheSize) {
+            [_normalizedSQL removeAllObjects];
+        }
+        _normalizedSQL[sql] = result;
+    }
+    return result;
+}
+
+- (void)recordPrepareOfSQL:(NSString *)normalizedSQL time:(uint64_t)time {
+    if (!normalizedSQL) {
+        return;
+    }
+    @synchronized (self) {
+        SCSqliteStatementProfile *profile = [self profileForSQL:normalizedSQL];
+        profile->_prepareCount++;
+        profile->_prepareTime += time;
+    }
+}
+
+- (void)recordExecutionOfSQL:(NSString *)normalizedSQL stepTime:(uint64_t)stepTime rows:(NSUInteger)rows sql:(NSString *)sql db:(sqlite3 *)db {
+    if (!normalizedSQL) {
+        return;
+    }
+    NSTimeInterval seconds = [self secondsFromMachTime:stepTime];
+    BOOL slow = seconds >= _slowQueryThreshold;
+    BOOL capturePlan = NO;
+    @synchronized (self) {
+        SCSqliteStatementProfile *profile = [self profileForSQL:normalizedSQL];
+        profile->_count++;
+        profile->_totalTime += stepTime;
+        profile->_maxTime = MAX(profile->_maxTime, stepTime);
+        profile->_rows += rows;
+        if (slow) {
+            [_slowQueries addObject:@{
+                @"sql":         normalizedSQL,
+                @"time":        [NSNumber numberWithDouble:seconds],
+                @"rows":        [NSNumber numberWithUnsignedInteger:rows],
+                @"timestamp":   [NSNumber numberWithDouble:[[NSDate date] timeIntervalSince1970]]
+            }];
+            while ([_slowQueries count] > _slowQueryLogSize) {
+                [_slowQueries removeObjectAtIndex:0];
+            }
+            capturePlan = (profile->_plan == nil);
+        }
+    }
+    if (slow) {
+        [Logger warn:@"Slow query (%.3fs, %lu rows): %@", seconds, (unsigned long)rows, normalizedSQL];
+    }
+    if (capturePlan) {
+        // Capture the query plan on the statement's connection, outside of the profiler lock.
+        NSArray *plan = [self queryPlanForSQL:sql db:db];
+        BOOL fullScan = [self planHasFullTableScan:plan sql:sql];
+        if (fullScan) {
+            [Logger warn:@"Full table scan: %@ %@", normalizedSQL, [plan componentsJoinedByString:@"; "]];
+        }
+        @synchronized (self) {
+            SCSqliteStatementProfile *profile = [self profileForSQL:normalizedSQL];
+            profile->_plan = plan;
+            profile->_fullScan = fullScan;
+        }
+    }
+}
+
+- (NSDictionary *)snapshot {
+    NSMutableDictionary *statements = [NSMutableDictionary new];
+    NSArray *slowQueries;
+    @synchronized (self) {
+        for (NSString *sql in _profiles) {
+            SCSqliteStatementProfile *profile = _profiles[sql];
+            NSMutableDictionary *stats = [@{
+                @"count":           [NSNumber numberWithUnsignedInteger:profile->_count],
+                @"totalTime":       [NSNumber numberWithDouble:[self secondsFromMachTime:profile->_totalTime]],
+                @"maxTime":         [NSNumber numberWithDouble:[self secondsFromMachTime:profile->_maxTime]],
+                @"rows":            [NSNumber numberWithUnsignedInteger:profile->_rows],
+                @"prepareCount":    [NSNumber numberWithUnsignedInteger:profile->_prepareCount],
+                @"prepareTime":     [NSNumber numberWithDouble:[self secondsFromMachTime:profile->_prepareTime]]
+            } mutableCopy];
+            if (profile->_plan) {
+                stats[@"plan"] = profile->_plan;
+                stats[@"fullScan"] = [NSNumber numberWithBool:profile->_fullScan];
+            }
+            statements[sql] = stats;
+        }
+        slowQueries = [_slowQueries copy];
+    }
+    return @{ @"statements": statements, @"slowQueries": slowQueries };
+}
+
+- (NSData *)JSONData {
+    NSError *error = nil;
+    NSData *data = [NSJSONSerialization dataWithJSONObject:[self snapshot] options:NSJSONWritingPrettyPrinted error:&error];
+    if (error) {
+        [Logger error:@"Unable to serialize profile: %@", [error localizedDescription]];
+    }
+    return data;
+}
+
+- (void)reset {
+    @synchronized (self) {
+        [_profiles removeAllObjects];
+        [_slowQueries removeAllObjects];
+    }
+}
+
+#pragma mark - Private methods
+
+- (SCSqliteStatementProfile *)profileForSQL:(NSString *)normalizedSQL {
+    SCSqliteStatementProfile *profile = _profiles[normalizedSQL];
+    if (!profile) {
+        profile = [SCSqliteStatementProfile new];
+        _profiles[normalizedSQL] = profile;
+    }
+    return profile;
+}
+
+- (NSArray *)queryPlanForSQL:(NSString *)sql db:(sqlite3 *)db {
+    NSMutableArray *plan = [NSMutableArray new];
+    NSString *explain = [NSString stringWithFormat:@"EXPLAIN QUERY PLAN %@", sql];
+    sqlite3_stmt *statement = NULL;
+    if (sqlite3_prepare_v2(db, [explain UTF8String], -1, &statement, NULL) == SQLITE_OK) {
+        // Result columns are id, parent, notused, detail.
+        int detailIdx = sqlite3_column_count(statement) - 1;
+        while (sqlite3_step(statement) == SQLITE_ROW) {
+            const unsigned char *detail = sqlite3_column_text(statement, detailIdx);
+            if (detail) {
+                [plan addObject:[NSString stringWithUTF8String:(const char *)detail]];
+            }
+        }
+    }
+    sqlite3_finalize(statement);
+    return plan;
+}
+
+- (BOOL)planHasFullTableScan:(NSArray *)plan sql:(NSString *)sql {
+    // A full table scan is reported as "SCAN t" or "SCAN TABLE t [AS a]"; index scans include "USING",
+    // and constant rows, subqueries and virtual tables are reported with additional words.
+    static NSRegularExpression *ScanPattern;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        ScanPattern = [NSRegularExpression regularExpressionWithPattern:@"^SCAN (?:TABLE )?(\\w+)(?: AS \\w+)?$"
+                                                                options:0
+                                                                  error:nil];
+    });
+    NSSet *derivedNames = nil;
+    for (NSString *detail in plan) {
+        NSTextCheckingResult *match = [ScanPattern firstMatchInString:detail options:0 range:NSMakeRange(0, [detail length])];
+        if (!match) {
+            continue;
+        }
+        if (!derivedNames) {
+            derivedNames = [self derivedTableNamesInPlan:plan sql:sql];
+        }
+        NSString *name = [[detail substringWithRange:[match rangeAtIndex:1]] lowercaseString];
+        if (![derivedNames containsObject:name]) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (NSSet *)derivedTableNamesInPlan:(NSArray *)plan sql:(NSString *)sql {
+    static NSRegularExpression *SourcePattern, *CTEPattern;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // Materialized subqueries and CTEs are introduced by a named step in the plan.
+        SourcePattern = [NSRegularExpression regularExpressionWithPattern:@"^(?:MATERIALIZE|CO-ROUTINE) (\\w+)$"
+                                                                  options:0
+                                                                    error:nil];
+        // Common table expression names in a WITH clause, e.g. "WITH c(x) AS (" or ", d AS MATERIALIZED (".
+        CTEPattern = [NSRegularExpression regularExpressionWithPattern:@"(?:\\bWITH(?:\\s+RECURSIVE)?|,)\\s*(\\w+)\\s*(?:\\([^)]*\\))?\\s*AS\\s*(?:NOT\\s+)?(?:MATERIALIZED\\s*)?\\("
+                                                               options:NSRegularExpressionCaseInsensitive
+                                                                 error:nil];
+    });
+    NSMutableSet *names = [NSMutableSet new];
+    for (NSString *detail in plan) {
+        NSTextCheckingResult *match = [SourcePattern firstMatchInString:detail options:0 range:NSMakeRange(0, [detail length])];
+        if (match) {
+            [names addObject:[[detail substringWithRange:[match rangeAtIndex:1]] lowercaseString]];
+        }
+    }
+    NSString *trimmedSQL = [sql stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+    if ([[trimmedSQL uppercaseString] hasPrefix:@"WITH"]) {
+        for (NSTextCheckingResult *match in [CTEPattern matchesInString:sql options:0 range:NSMakeRange(0, [sql length])]) {
+            [names addObject:[[sql substringWithRange:[match rangeAtIndex:1]] lowercaseString]];
+        }
+    }
+    // A derived table may be scanned under an alias, e.g. "FROM c AS d".
+    for (NSString *name in [names allObjects]) {
+        NSString *pattern = [NSString stringWithFormat:@"\\b%@\\s+(?:AS\\s+)?(\\w+)", [NSRegularExpression escapedPatternForString:name]];
+        NSRegularExpression *aliasPattern = [NSRegularExpression regularExpressionWithPattern:pattern
+                                                                                      options:NSRegularExpressionCaseInsensitive
+                                                                                        error:nil];
+        for (NSTextCheckingResult *match in [aliasPattern matchesInString:sql options:0 range:NSMakeRange(0, [sql length])]) {
+            [names addObject:[[sql substringWithRange:[match rangeAtIndex:1]] lowercaseString]];
+        }
+    }
+    return names;
+}
+
+- (NSTimeInterval)secondsFromMachTime:(uint64_t)time {
+    static mach_timebase_info_data_t Timebase;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mach_timebase_info(&Timebase);
+    });
+    return (double)time * Timebase.numer / Timebase.denom / NSEC_PER_SEC;
+}
+
+@end
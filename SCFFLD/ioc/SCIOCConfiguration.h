@@ -32,6 +32,12 @@
 /// Initialize a configuration with the specified data and parent configuration.
 - (id)initWithData:(id)data parent:(id<SCConfiguration>)parent;
 
+/**
+ * Return the identified representation of the configuration value at the specified key path.
+ * Equivalent to _getValue:asRepresentation:_, but without the representation name lookup.
+ */
+- (id)getValue:(NSString *)keyPath asRepresentationType:(SCRepresentation)representation;
+
 /// Returns a singleton-instance empty configuration object.
 + (id<SCConfiguration>)emptyConfiguration;
 
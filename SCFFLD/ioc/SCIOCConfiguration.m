@@ -20,6 +20,8 @@
 #import "SCRegExp.h"
 #import "SCStringTemplate.h"
 #import "SCTypeConversions.h"
+#import "SCCompiledJSON.h"
+#import "SCInternTable.h"
 #import "SCStandardURIHandler.h"
 #import "NSDictionary+SC.h"
 #import "UIColor+SC.h"
@@ -34,9 +36,7 @@
 // use a reference to the new configuration in its place.
 #define NormalizedRootRef(cfg)  ((self == _topLevelConfig) ? cfg : _topLevelConfig)
 
-@interface SCArrayBackedDictionary : NSDictionary {
-    NSNumberFormatter *_numParser;
-}
+@interface SCArrayBackedDictionary : NSDictionary
 
 @property (nonatomic, strong) NSArray *array;
 
@@ -48,6 +48,18 @@
 
 - (id)initWithConfiguration:(id<SCConfiguration>)config mixin:(id<SCConfiguration>)mixin parent:(id<SCConfiguration>)parent;
 - (void)initializeContext;
+/// Resolve any prefix modifiers ($ ? > @ # `) on a single configuration value.
+- (id)resolveValue:(id)value representation:(SCRepresentation)representation;
+/// Convert a resolved configuration value to the identified representation.
+- (id)value:(id)value asRepresentationType:(SCRepresentation)representation;
+/**
+ * Return a configuration for an item of a list or map value.
+ * The item is resolved directly against the collection it belongs to, so no key path
+ * needs to be generated and then resolved again from the configuration root.
+ */
+- (id<SCConfiguration>)configurationForItem:(id)item;
+/// Test whether the configuration has any -config, -mixin, -mixins or -extends properties.
+- (BOOL)requiresNormalization;
 
 @end
 
@@ -70,13 +82,19 @@
 }
 
 - (id)initWithData:(id)data {
+    if ([data isKindOfClass:[NSString class]]) {
+        // Share repeated keys and short values within the loaded configuration.
+        data = [SCTypeConversions asJSONData:data internTable:[SCInternTable new]];
+    }
     self = [self initWithData:data parent:[SCIOCConfiguration emptyConfiguration]];
     self.topLevelConfig = self;
     return self;
 }
 
 - (id)initWithResource:(SCResource *)resource {
-    self = [self initWithData:[resource asJSONData]];
+    // Share repeated keys and short values within the loaded configuration.
+    id data = [resource asJSONDataWithInternTable:[SCInternTable new]];
+    self = [self initWithData:data];
     if (self) {
         self.uriHandler = resource.uriHandler;
         [self initializeContext];
@@ -125,26 +143,26 @@
 }
 
 - (void)initializeContext {
-    NSMutableDictionary *params = [NSMutableDictionary new];
-    NSMutableDictionary *values = [NSMutableDictionary new];
-    // Search the configuration data for any parameter values, filter parameter values out of main data values.
-    for (NSString *name in [_configData allKeys]) {
+    NSMutableDictionary *params = nil;
+    // Search the configuration data for any parameter values.
+    for (NSString *name in [_configData keyEnumerator]) {
         if ([name hasPrefix:@"$"]) {
+            if (!params) {
+                params = [NSMutableDictionary new];
+            }
             params[name] = _configData[name];
         }
-        else {
-            values[name] = _configData[name];
-        }
     }
-    // Initialize/modify the context with parameter values, if any.
-    if ([params count]) {
+    // Initialize/modify the context with parameter values, if any, and filter parameter
+    // values out of main data values.
+    if (params) {
         if (self.dataContext) {
             self.dataContext = [self.dataContext extendWith:params];
         }
         else {
             self.dataContext = params;
         }
-        self.configData = values;
+        self.configData = [_configData dictionaryWithKeysExcluded:[params allKeys]];
     }
     else if (!self.dataContext) {
         self.dataContext = [NSDictionary dictionary];
@@ -188,6 +206,16 @@
 }
 
 - (id)getValue:(NSString*)keyPath asRepresentation:(NSString *)representation {
+    SCRepresentation representationType = [SCTypeConversions representationForName:representation];
+    if (representationType == SCRepresentationUnknown) {
+        // Unrecognized representation names may still be supported by resource values.
+        id value = [self getValue:keyPath asRepresentationType:SCRepresentationRaw];
+        return [value isKindOfClass:[SCResource class]] ? [(SCResource *)value asRepresentation:representation] : nil;
+    }
+    return [self getValue:keyPath asRepresentationType:representationType];
+}
+
+- (id)getValue:(NSString *)keyPath asRepresentationType:(SCRepresentation)representation {
     id value = _configData;
     NSArray *components = [keyPath componentsSeparatedByString:@"."];
     for (NSString *key in components) {
@@ -195,8 +223,19 @@
         if ([value isKindOfClass:[SCResource class]]) {
             value = [(SCResource *)value asJSONData];
         }
-        // Lookup the key value on the current object.
-        if ([value isKindOfClass:[NSArray class]]) {
+        // Lookup the key value on the current object. Compiled JSON records the prefix class of
+        // each string value, so values without a prefix don't need resolving.
+        if ([value conformsToProtocol:@protocol(SCCompiledJSONContainer)]) {
+            SCCompiledJSONPrefix prefix;
+            value = [(id<SCCompiledJSONContainer>)value valueForKeyComponent:key prefix:&prefix];
+            if (value == nil) {
+                break;
+            }
+            if (prefix == SCCompiledJSONPrefixNone) {
+                continue;
+            }
+        }
+        else if ([value isKindOfClass:[NSArray class]]) {
             NSInteger idx = [key integerValue];
             value = value[idx];
         }
@@ -209,74 +248,88 @@
         // Continue if we have a value, else break out of the loop.
         if (value != nil) {
             // Modify the value by accounting for any value prefixes.
-            if ([value isKindOfClass:[NSString class]]) {
-                // Interpret the string value.
-                NSString* valueStr = (NSString *)value;
-                // First, attempt resolving any context references. If these in turn resolve to a
-                // $ or # prefixed value, then they will be resolved in the following code.
-                if ([valueStr hasPrefix:@"$"]) {
-                    value = _dataContext[valueStr];
-                    // If context value is also a string then continue to following modifiers...
-                    if ([value isKindOfClass:[NSString class]]) {
-                        valueStr = (NSString *)value;
-                    }
-                    else {
-                        // ...else continue to next key.
-                        continue;
-                    }
-                }
-                // Evaluate any string beginning with ? or > as a string template.
-                if ([valueStr hasPrefix:@"?"] || [valueStr hasPrefix:@">"]) {
-                    valueStr = [valueStr substringFromIndex:1];
-                    valueStr = [SCStringTemplate render:valueStr context:_dataContext];
-                }
-                // String values beginning with @ are internal URI references, so dereference the URI.
-                if ([valueStr hasPrefix:@"@"]) {
-                    NSString *uri = [valueStr substringFromIndex:1];
-                    value = [_uriHandler dereference:uri];
-                }
-                // Any string values starting with a '#' are potential path references to other
-                // properties in the same configuration. Attempt to resolve them against the configuration
-                // root; if they don't resolve then return the original value.
-                else if ([valueStr hasPrefix:@"#"]) {
-                    value = [_topLevelConfig getValue:[valueStr substringFromIndex:1] asRepresentation:representation];
-                    if (value == nil) {
-                        // If no value resolved then reset value to the #string
-                        value = valueStr;
-                    }
-                }
-                else if ([valueStr hasPrefix:@"`"]) {
-                    value = [valueStr substringFromIndex:1];
-                }
-                else if (valueStr) {
-                    value = valueStr;
-                }
-            }
+            value = [self resolveValue:value representation:representation];
         }
         else {
             break;
         }
     }
-    
-    // If something other than the raw representation is required then try to convert:
-    // * configuration: See the asConfiguration: method;
-    // * all other representations are passed to TypeConversions.
-    if (![@"raw" isEqualToString:representation]) {
-        if ([@"configuration" isEqualToString:representation]) {
-            value = [self asConfiguration:value];
+    return [self value:value asRepresentationType:representation];
+}
+
+- (id)resolveValue:(id)value representation:(SCRepresentation)representation {
+    if ([value isKindOfClass:[NSString class]]) {
+        // Interpret the string value.
+        NSString* valueStr = (NSString *)value;
+        // First, attempt resolving any context references. If these in turn resolve to a
+        // $ or # prefixed value, then they will be resolved in the following code.
+        if ([valueStr hasPrefix:@"$"]) {
+            value = _dataContext[valueStr];
+            // If context value is also a string then continue to following modifiers...
+            if ([value isKindOfClass:[NSString class]]) {
+                valueStr = (NSString *)value;
+            }
+            else {
+                // ...else return the context value as is.
+                return value;
+            }
         }
-        else if ([value isKindOfClass:[SCResource class]]) {
-            value = [(SCResource *)value asRepresentation:representation];
+        // Evaluate any string beginning with ? or > as a string template.
+        if ([valueStr hasPrefix:@"?"] || [valueStr hasPrefix:@">"]) {
+            valueStr = [valueStr substringFromIndex:1];
+            valueStr = [SCStringTemplate render:valueStr context:_dataContext];
         }
-        else {
-            value = [SCTypeConversions value:value asRepresentation:representation];
+        // String values beginning with @ are internal URI references, so dereference the URI.
+        if ([valueStr hasPrefix:@"@"]) {
+            NSString *uri = [valueStr substringFromIndex:1];
+            value = [_uriHandler dereference:uri];
+        }
+        // Any string values starting with a '#' are potential path references to other
+        // properties in the same configuration. Attempt to resolve them against the configuration
+        // root; if they don't resolve then return the original value.
+        else if ([valueStr hasPrefix:@"#"]) {
+            NSString *refKeyPath = [valueStr substringFromIndex:1];
+            if ([_topLevelConfig isKindOfClass:[SCIOCConfiguration class]]) {
+                value = [(SCIOCConfiguration *)_topLevelConfig getValue:refKeyPath asRepresentationType:representation];
+            }
+            else {
+                value = [_topLevelConfig getValue:refKeyPath asRepresentation:[SCTypeConversions nameForRepresentation:representation]];
+            }
+            if (value == nil) {
+                // If no value resolved then reset value to the #string
+                value = valueStr;
+            }
+        }
+        else if ([valueStr hasPrefix:@"`"]) {
+            value = [valueStr substringFromIndex:1];
+        }
+        else if (valueStr) {
+            value = valueStr;
         }
     }
     return value;
 }
 
+- (id)value:(id)value asRepresentationType:(SCRepresentation)representation {
+    // If something other than the raw representation is required then try to convert:
+    // * configuration: See the asConfiguration: method;
+    // * resources are asked for the representation;
+    // * all other representations are passed to TypeConversions.
+    switch (representation) {
+    case SCRepresentationRaw:
+        return value;
+    case SCRepresentationConfiguration:
+        return [self asConfiguration:value];
+    default:
+        if ([value isKindOfClass:[SCResource class]]) {
+            return [(SCResource *)value asRepresentationType:representation];
+        }
+        return [SCTypeConversions value:value asRepresentationType:representation];
+    }
+}
+
 - (BOOL)hasValue:(NSString *)keyPath {
-    return [self getValue:keyPath asRepresentation:@"raw"] != nil;
+    return [self getValue:keyPath asRepresentationType:SCRepresentationRaw] != nil;
 }
 
 - (NSString *)getValueAsString:(NSString *)keyPath {
@@ -284,7 +337,7 @@
 }
 
 - (NSString *)getValueAsString:(NSString*)keyPath defaultValue:(NSString*)defaultValue {
-    NSString* value = [self getValue:keyPath asRepresentation:@"string"];
+    NSString* value = [self getValue:keyPath asRepresentationType:SCRepresentationString];
     return value == nil || ![value isKindOfClass:[NSString class]] ? defaultValue : value;
 }
 
@@ -298,7 +351,7 @@
 }
 
 - (NSNumber *)getValueAsNumber:(NSString*)keyPath defaultValue:(NSNumber*)defaultValue {
-    NSNumber* value = [self getValue:keyPath asRepresentation:@"number"];
+    NSNumber* value = [self getValue:keyPath asRepresentationType:SCRepresentationNumber];
     return value == nil || ![value isKindOfClass:[NSNumber class]] ? defaultValue : value;
 }
 
@@ -307,7 +360,7 @@
 }
 
 - (BOOL)getValueAsBoolean:(NSString*)keyPath defaultValue:(BOOL)defaultValue {
-    NSNumber* value = [self getValue:keyPath asRepresentation:@"number"];
+    NSNumber* value = [self getValue:keyPath asRepresentationType:SCRepresentationNumber];
     return value == nil ? defaultValue : [value boolValue];
 }
 
@@ -318,7 +371,7 @@
 
 // Resolve a date value on the cell data at the specified path, return the default value if not set.
 - (NSDate *)getValueAsDate:(NSString *)keyPath defaultValue:(NSDate *)defaultValue {
-    NSDate *value = [self getValue:keyPath asRepresentation:@"date"];
+    NSDate *value = [self getValue:keyPath asRepresentationType:SCRepresentationDate];
     return value == nil || ![value isKindOfClass:[NSDate class]] ? defaultValue : value;
 }
 
@@ -332,26 +385,26 @@
 }
 
 - (NSURL *)getValueAsURL:(NSString *)keyPath {
-    NSURL *value = [self getValue:keyPath asRepresentation:@"url"];
+    NSURL *value = [self getValue:keyPath asRepresentationType:SCRepresentationURL];
     return [value isKindOfClass:[NSURL class]] ? value : nil;
 }
 
 - (NSData *)getValueAsData:(NSString *)keyPath {
-    NSData *value = [self getValue:keyPath asRepresentation:@"data"];
+    NSData *value = [self getValue:keyPath asRepresentationType:SCRepresentationData];
     return [value isKindOfClass:[NSData class]] ? value : nil;
 }
 
 - (UIImage *)getValueAsImage:(NSString *)keyPath {
-    UIImage *value = [self getValue:keyPath asRepresentation:@"image"];
+    UIImage *value = [self getValue:keyPath asRepresentationType:SCRepresentationImage];
     return [value isKindOfClass:[UIImage class]] ? value : nil;
 }
 
 - (id)getValue:(NSString *)keyPath {
-    return [self getValue:keyPath asRepresentation:@"raw"];
+    return [self getValue:keyPath asRepresentationType:SCRepresentationRaw];
 }
 
 - (id)getValueAsJSONData:(NSString *)keyPath {
-    id value = [self getValue:keyPath asRepresentation:@"raw"];
+    id value = [self getValue:keyPath asRepresentationType:SCRepresentationRaw];
     if ([value isKindOfClass:[SCResource class]]) {
         value = [(SCResource *)value asJSONData];
     }
@@ -363,7 +416,7 @@
 }
 
 - (id<SCConfiguration>)getValueAsConfiguration:(NSString *)keyPath {
-    return [[self getValue:keyPath asRepresentation:@"configuration"] normalize];
+    return [[self getValue:keyPath asRepresentationType:SCRepresentationConfiguration] normalize];
 }
 
 - (id<SCConfiguration>)getValueAsConfiguration:(NSString *)keyPath defaultValue:(id<SCConfiguration>)defaultValue {
@@ -374,14 +427,9 @@
     NSMutableArray *result = [[NSMutableArray alloc] init];
     id value = [self getValue:keyPath];
     if ([value isKindOfClass:[NSArray class]]) {
-        NSArray *valuesArray = (NSArray *)value;
-        if (![valuesArray isKindOfClass:[NSArray class]]) {
-            valuesArray = [self getValue:keyPath asRepresentation:@"json"];
-        }
-        if ([valuesArray isKindOfClass:[NSArray class]]) {
-            for (NSInteger i = 0; i < [valuesArray count]; i++) {
-                NSString *itemKeyPath = [NSString stringWithFormat:@"%@.%ld", keyPath, (long)i];
-                id<SCConfiguration> item = [self getValueAsConfiguration:itemKeyPath];
+        for (id itemValue in (NSArray *)value) {
+            id<SCConfiguration> item = [self configurationForItem:itemValue];
+            if (item) {
                 [result addObject:item];
             }
         }
@@ -394,15 +442,23 @@
     id values = [self getValue:keyPath];
     if ([values isKindOfClass:[NSDictionary class]]) {
         NSDictionary *valuesDictionary = (NSDictionary *)values;
-        for (id key in [valuesDictionary allKeys]) {
-            NSString *itemKeyPath = [NSString stringWithFormat:@"%@.%@", keyPath, key];
-            id<SCConfiguration> item = [self getValueAsConfiguration:itemKeyPath];
-            [result setObject:item forKey:key];
+        for (id key in [valuesDictionary keyEnumerator]) {
+            id<SCConfiguration> item = [self configurationForItem:valuesDictionary[key]];
+            if (item) {
+                [result setObject:item forKey:key];
+            }
         }
     }
     return result;
 }
 
+- (id<SCConfiguration>)configurationForItem:(id)item {
+    // Equivalent to getValueAsConfiguration: with the item's key path, but without the key
+    // path lookup; the item config shares the root, context and URI handler of this config.
+    item = [self resolveValue:item representation:SCRepresentationConfiguration];
+    return [[self value:item asRepresentationType:SCRepresentationConfiguration] normalize];
+}
+
 - (id<SCConfiguration>)mixinConfiguration:(id<SCConfiguration>)otherConfig {
     return [[SCIOCConfiguration alloc] initWithConfiguration:self mixin:otherConfig parent:self];
 }
@@ -444,7 +500,19 @@
     return result;
 }
 
+- (BOOL)requiresNormalization {
+    return _configData[@"-config"] != nil
+        || _configData[@"-mixin"] != nil
+        || _configData[@"-mixins"] != nil
+        || _configData[@"-extends"] != nil;
+}
+
 - (id<SCConfiguration>)normalize {
+    // Configurations without mixins or an extension hierarchy are already in normal form, so
+    // return as is; this avoids a full copy of every item config in lists and maps.
+    if (![self requiresNormalization]) {
+        return self;
+    }
     // Build a hierarchy of configurations extended by other configs.
     NSMutableArray *hierarchy = [NSMutableArray new];
     id<SCConfiguration> current = [self flatten];
@@ -497,13 +565,68 @@ static SCIOCConfiguration *emptyConfiguaration;
 @end
 
 // NSDictionary interface backed by an NSArray
+
+// The maximum number of decimal digits parsed in an array index key.
+#define MaxIndexKeyLength 18
+
+// Parse an array index from a dictionary key. Returns -1 if the key isn't a valid index.
+static NSInteger SCArrayIndexForKey(id key) {
+    if ([key isKindOfClass:[NSNumber class]]) {
+        return [(NSNumber *)key integerValue];
+    }
+    NSString *str = [key isKindOfClass:[NSString class]] ? (NSString *)key : [key description];
+    NSUInteger length = [str length];
+    if (length == 0 || length > MaxIndexKeyLength) {
+        return -1;
+    }
+    unichar chars[MaxIndexKeyLength];
+    [str getCharacters:chars range:NSMakeRange(0, length)];
+    NSInteger idx = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar ch = chars[i];
+        if (ch < '0' || ch > '9') {
+            return -1;
+        }
+        idx = (idx * 10) + (ch - '0');
+    }
+    return idx;
+}
+
+/// An enumerator of the index keys ("0", "1", "2"...) of an array backed dictionary; keys are formatted on demand.
+@interface SCArrayIndexKeyEnumerator : NSEnumerator {
+    NSUInteger _index;
+    NSUInteger _count;
+}
+
+- (id)initWithCount:(NSUInteger)count;
+
+@end
+
+@implementation SCArrayIndexKeyEnumerator
+
+- (id)initWithCount:(NSUInteger)count {
+    self = [super init];
+    if (self) {
+        _count = count;
+    }
+    return self;
+}
+
+- (id)nextObject {
+    if (_index < _count) {
+        return [NSString stringWithFormat:@"%lu", (unsigned long)_index++];
+    }
+    return nil;
+}
+
+@end
+
 @implementation SCArrayBackedDictionary
 
 - (id)initWithArray:(NSArray *)array {
     self = [super init];
     if (self) {
         _array = array;
-        _numParser = [NSNumberFormatter new];
     }
     return self;
 }
@@ -513,19 +636,12 @@ static SCIOCConfiguration *emptyConfiguaration;
 }
 
 - (id)objectForKey:(id)aKey {
-    // TODO: Need to test whether [_array valueForKey:aKey] will return the same result.
-    NSNumber *num = [_numParser numberFromString:[aKey description]];
-    NSInteger idx = num != nil ? num.integerValue : -1;
+    NSInteger idx = SCArrayIndexForKey(aKey);
     return idx > -1 && idx < [_array count] ? [_array objectAtIndex:idx] : nil;
 }
 
 - (NSEnumerator *)keyEnumerator {
-    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:[_array count]];
-    for (NSInteger idx = 0; idx < [_array count]; idx++) {
-        NSString *key = [[NSNumber numberWithInteger:idx] description];
-        [keys addObject:key];
-    }
-    return [keys objectEnumerator];
+    return [[SCArrayIndexKeyEnumerator alloc] initWithCount:[_array count]];
 }
 
 @end
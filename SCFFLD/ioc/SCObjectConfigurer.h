@@ -34,6 +34,8 @@
     SCTypeInfo *_containerTypeInfo;
     /// The object logger.
     SCLogger *_logger;
+    /// Normalized property names, keyed by the -ios: prefixed names they were derived from.
+    NSMutableDictionary *_normalizedNames;
 }
 
 /**
@@ -384,19 +384,30 @@
 #pragma mark - Private methods
 
 - (NSString *)normalizePropertyName:(NSString *)name {
-    if ([name hasPrefix:@"-"]) {
-        if ([name hasPrefix:@"-ios:"]) {
-            // Strip -ios prefix from names.
-            name = [name substringFromIndex:5];
-            // Don't process class names.
-            if ([@"-class" isEqualToString:name]) {
-                name = nil;
+    // Most names aren't reserved, so test the first character before any prefix matching.
+    if ([name length] == 0 || [name characterAtIndex:0] != '-') {
+        return name;
+    }
+    if ([name hasPrefix:@"-ios:"]) {
+        // Strip -ios prefix from names; remember the result so that repeated names don't allocate
+        // a new substring each time they're seen.
+        NSString *normalized = _normalizedNames[name];
+        if (!normalized) {
+            normalized = [name substringFromIndex:5];
+            if (!_normalizedNames) {
+                _normalizedNames = [NSMutableDictionary new];
             }
+            _normalizedNames[name] = normalized;
         }
-        else {
-            name = nil; // Skip all other reserved names
+        name = normalized;
+        // Don't process class names.
+        if ([@"-class" isEqualToString:name]) {
+            name = nil;
         }
     }
+    else {
+        name = nil; // Skip all other reserved names
+    }
     return name;
 }
 
@@ -18,6 +18,7 @@
 
 #import "SCFileResource.h"
 #import "SCTypeConversions.h"
+#import "SCCompiledJSON.h"
 
 @implementation SCFileDescription
 
@@ -73,27 +74,33 @@
     return image;
 }
 
-- (id)asJSONData {
-    return [SCTypeConversions asJSONData:[self asString]];
+- (id)asJSONDataWithInternTable:(SCInternTable *)internTable {
+    // Use a compiled version of the file's JSON, if one was generated at build time.
+    NSString *compiledPath = [SCCompiledJSON compiledPathForPath:self.fileDescription.path];
+    if ([[NSFileManager defaultManager] fileExistsAtPath:compiledPath]) {
+        id jsonData = [SCCompiledJSON JSONObjectWithContentsOfFile:compiledPath];
+        if (jsonData) {
+            return jsonData;
+        }
+    }
+    return [SCTypeConversions asJSONData:[self asString] internTable:internTable];
 }
 
-- (id)asRepresentation:(NSString *)representation {
-    if ([@"string" isEqualToString:representation]) {
+- (id)asRepresentationType:(SCRepresentation)representation {
+    switch (representation) {
+    case SCRepresentationString:
         return [self asString];
-    }
-    if ([@"data" isEqualToString:representation]) {
+    case SCRepresentationData:
         return [self asData];
-    }
-    if ([@"image" isEqualToString:representation]) {
+    case SCRepresentationImage:
         return [self asImage];
-    }
-    if ([@"json" isEqualToString:representation]) {
+    case SCRepresentationJSON:
         return [self asJSONData];
-    }
-    if ([@"filepath" isEqualToString:representation]) {
+    case SCRepresentationFilePath:
         return self.fileDescription.path;
+    default:
+        return [super asRepresentationType:representation];
     }
-    return [super asRepresentation:representation];
 }
 
 - (NSURL *)externalURL {
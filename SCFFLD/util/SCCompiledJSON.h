@@ -0,0 +1,93 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/// The file extension used for compiled JSON files.
+#define SCCompiledJSONFileExtension (@"cjson")
+
+/// The prefix class of a compiled JSON string value; see SCIOCConfiguration for the meaning of each prefix.
+typedef NS_ENUM(NSInteger, SCCompiledJSONPrefix) {
+    /// Not a string value, or a string without a value prefix.
+    SCCompiledJSONPrefixNone = 0,
+    SCCompiledJSONPrefixDollar,
+    SCCompiledJSONPrefixQuestion,
+    SCCompiledJSONPrefixGreaterThan,
+    SCCompiledJSONPrefixAt,
+    SCCompiledJSONPrefixHash,
+    SCCompiledJSONPrefixBacktick
+};
+
+/// A protocol implemented by the objects and arrays of a compiled JSON document.
+@protocol SCCompiledJSONContainer <NSObject>
+
+/**
+ * Return the value of an object entry or array item, and its prefix class.
+ * @param key       An object key; or for an array, an item index.
+ * @param prefix    Set to the prefix class of the value.
+ */
+- (id)valueForKeyComponent:(NSString *)key prefix:(SCCompiledJSONPrefix *)prefix;
+
+@end
+
+/**
+ * A reader for compiled JSON data.
+ * Compiled JSON is a binary form of a JSON document, produced at build time by the
+ * _bin/compile-config.py_ script. Objects and arrays in the document are returned as
+ * NSDictionary and NSArray instances which read their members directly from the
+ * compiled data as they are accessed, so only the parts of a document actually used
+ * are ever decoded. All strings in the document are stored once in a shared string
+ * table, and each distinct string is only decoded once per document.
+ *
+ * File layout (all integers little-endian, all offsets are from the start of the data):
+ *
+ *     Header:   char[4] magic ("SCJB"), u8 version, u8[3] reserved,
+ *               u32 string table offset, u32 root value offset
+ *     Strings:  u32 count, count * { u32 offset, u32 byte length } of UTF-8 data
+ *     Values:   u8 tag, followed by a tag specific payload:
+ *               0x00 null; 0x01 false; 0x02 true; 0x03 int64; 0x04 double;
+ *               0x1P string: u32 string index; P is the value prefix class,
+ *                    0 = none, 1 = $, 2 = ?, 3 = >, 4 = @, 5 = #, 6 = `
+ *               0x20 array:  u32 count, u32 end offset, count * u32 item offset
+ *               0x21 object: u32 count, u32 end offset, count * { u32 key index, u32 value offset }
+ *                    (entries are sorted by the UTF-8 bytes of their keys)
+ *
+ * The end offset of arrays and objects allows readers to skip whole subtrees.
+ *
+ * Values decoded from an object or array are cached by the container, and strings are cached by
+ * the reader, so repeated reads return the same instances. Reads are thread safe, and don't lock.
+ */
+@interface SCCompiledJSON : NSObject
+
+/// Initialize a reader with compiled JSON data.
+- (id)initWithData:(NSData *)data;
+
+/// The document's root value; or _nil_ if the data isn't valid compiled JSON.
+- (id)rootValue;
+
+/// Test whether a data object contains compiled JSON.
++ (BOOL)isCompiledJSONData:(NSData *)data;
+/**
+ * Read the root value of a compiled JSON file.
+ * The file is memory-mapped, and values are decoded lazily as they are accessed.
+ * @return The document's root value; or _nil_ if the file can't be read or isn't valid compiled JSON.
+ */
++ (id)JSONObjectWithContentsOfFile:(NSString *)path;
+/// Return the path of the compiled version of a JSON file.
++ (NSString *)compiledPathForPath:(NSString *)path;
+
+@end
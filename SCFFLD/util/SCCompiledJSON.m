@@ -0,0 +1,493 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+
+#import "SCCompiledJSON.h"
+#import "SCLogger.h"
+#import <libkern/OSByteOrder.h>
+#import <stdatomic.h>
+
+#define SCCompiledJSONMagic         ("SCJB")
+#define SCCompiledJSONVersion       (1)
+#define SCCompiledJSONHeaderSize    (16)
+// Size of an array or object value header - tag, count and end offset.
+#define ContainerHeaderSize         (9)
+#define ArrayEntrySize              (4)
+#define ObjectEntrySize             (8)
+
+#define TagNull     0x00
+#define TagFalse    0x01
+#define TagTrue     0x02
+#define TagInt      0x03
+#define TagDouble   0x04
+#define TagString   0x10
+#define TagArray    0x20
+#define TagObject   0x21
+
+// The highest prefix class value defined by the file format.
+#define MaxPrefixClass  SCCompiledJSONPrefixBacktick
+
+static inline uint32_t ReadUInt32(const uint8_t *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return OSSwapLittleToHostInt32(value);
+}
+
+static inline uint64_t ReadUInt64(const uint8_t *bytes) {
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return OSSwapLittleToHostInt64(value);
+}
+
+/// A slot holding a lazily decoded value, retained by the slot once set.
+typedef _Atomic(void *) SCCompiledJSONSlot;
+
+/// Allocate an array of empty slots.
+static SCCompiledJSONSlot *AllocSlots(NSUInteger count) {
+    return count > 0 ? (SCCompiledJSONSlot *)calloc(count, sizeof(SCCompiledJSONSlot)) : NULL;
+}
+
+/// Release the values held by an array of slots, and free the array.
+static void FreeSlots(SCCompiledJSONSlot *slots, NSUInteger count) {
+    if (slots) {
+        for (NSUInteger idx = 0; idx < count; idx++) {
+            void *value = atomic_load_explicit(&slots[idx], memory_order_relaxed);
+            if (value) {
+                CFRelease(value);
+            }
+        }
+        free(slots);
+    }
+}
+
+/// Return the value held by a slot; or nil if the slot is empty.
+static inline id SlotValue(SCCompiledJSONSlot *slot) {
+    return (__bridge id)atomic_load_explicit(slot, memory_order_acquire);
+}
+
+/**
+ * Store a value in an empty slot and return it.
+ * If another thread filled the slot first then its value is returned instead, so that all readers
+ * see the same instance.
+ */
+static id StoreSlotValue(SCCompiledJSONSlot *slot, id value) {
+    if (value == nil) {
+        return nil;
+    }
+    void *expected = NULL;
+    void *retained = (void *)CFBridgingRetain(value);
+    if (atomic_compare_exchange_strong_explicit(slot, &expected, retained, memory_order_acq_rel, memory_order_acquire)) {
+        return value;
+    }
+    CFRelease(retained);
+    return (__bridge id)expected;
+}
+
+@interface SCCompiledJSON () {
+    /// The compiled data.
+    NSData *_data;
+    /// The compiled data bytes; NULL if the data isn't valid.
+    const uint8_t *_bytes;
+    /// The length of the compiled data.
+    NSUInteger _length;
+    /// The offset of the string table.
+    uint32_t _stringTableOffset;
+    /// The number of strings in the string table.
+    uint32_t _stringCount;
+    /// Strings decoded from the string table, by string index.
+    SCCompiledJSONSlot *_strings;
+}
+
+/// Read the value at the specified offset.
+- (id)valueAtOffset:(uint32_t)offset;
+/// Return the prefix class of the value at the specified offset.
+- (SCCompiledJSONPrefix)prefixOfValueAtOffset:(uint32_t)offset;
+/// Read a string from the string table.
+- (NSString *)stringAtIndex:(uint32_t)idx;
+/// Return the key of the nth entry of the object at the specified offset.
+- (NSString *)keyAtIndex:(uint32_t)idx ofObjectAtOffset:(uint32_t)offset;
+/// Return the value offset of the nth entry of the object at the specified offset.
+- (uint32_t)valueOffsetOfEntry:(uint32_t)idx ofObjectAtOffset:(uint32_t)offset;
+/// Return the index of the named entry of the object at the specified offset; or NSNotFound.
+- (NSUInteger)indexOfKey:(NSString *)key ofObjectAtOffset:(uint32_t)offset count:(uint32_t)count;
+/// Return the offset of the nth item of the array at the specified offset.
+- (uint32_t)offsetOfItem:(uint32_t)idx ofArrayAtOffset:(uint32_t)offset;
+
+@end
+
+/// An NSDictionary interface onto an object in a compiled JSON document.
+@interface SCCompiledJSONObject : NSDictionary <SCCompiledJSONContainer> {
+    SCCompiledJSON *_json;
+    uint32_t _offset;
+    uint32_t _count;
+    /// Entry values decoded from the document, by entry index.
+    SCCompiledJSONSlot *_values;
+}
+
+- (id)initWithJSON:(SCCompiledJSON *)json offset:(uint32_t)offset count:(uint32_t)count;
+/// Return the key of the nth entry.
+- (NSString *)keyAtIndex:(uint32_t)idx;
+
+@end
+
+/// An NSArray interface onto an array in a compiled JSON document.
+@interface SCCompiledJSONArray : NSArray <SCCompiledJSONContainer> {
+    SCCompiledJSON *_json;
+    uint32_t _offset;
+    uint32_t _count;
+    /// Item values decoded from the document, by item index.
+    SCCompiledJSONSlot *_values;
+}
+
+- (id)initWithJSON:(SCCompiledJSON *)json offset:(uint32_t)offset count:(uint32_t)count;
+
+@end
+
+/// An enumerator over the keys of a compiled JSON object, which reads each key as it's requested.
+@interface SCCompiledJSONKeyEnumerator : NSEnumerator {
+    SCCompiledJSONObject *_object;
+    uint32_t _index;
+    uint32_t _count;
+}
+
+- (id)initWithObject:(SCCompiledJSONObject *)object count:(uint32_t)count;
+
+@end
+
+@implementation SCCompiledJSON
+
+- (id)initWithData:(NSData *)data {
+    self = [super init];
+    if (self) {
+        _data = data;
+        _length = [data length];
+        if ([SCCompiledJSON isCompiledJSONData:data]) {
+            const uint8_t *bytes = [data bytes];
+            uint8_t version = bytes[4];
+            _stringTableOffset = ReadUInt32(&bytes[8]);
+            BOOL valid = (version == SCCompiledJSONVersion) && ((NSUInteger)_stringTableOffset + 4 <= _length);
+            if (valid) {
+                _stringCount = ReadUInt32(&bytes[_stringTableOffset]);
+                valid = ((NSUInteger)_stringTableOffset + 4 + ((NSUInteger)_stringCount * 8) <= _length);
+            }
+            if (valid) {
+                _bytes = bytes;
+                _strings = AllocSlots(_stringCount);
+            }
+            else {
+                [SCLogger withTag:@"SCCompiledJSON" error:@"Invalid compiled JSON data (version %d)", version];
+            }
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    FreeSlots(_strings, _stringCount);
+}
+
+- (id)rootValue {
+    if (_bytes == NULL) {
+        return nil;
+    }
+    return [self valueAtOffset:ReadUInt32(&_bytes[12])];
+}
+
+- (id)valueAtOffset:(uint32_t)offset {
+    if (offset >= _length) {
+        return nil;
+    }
+    uint8_t tag = _bytes[offset];
+    if ((tag & 0xF0) == TagString) {
+        // The string includes its prefix; see prefixOfValueAtOffset: for the prefix class.
+        return (offset + 5 <= _length) ? [self stringAtIndex:ReadUInt32(&_bytes[offset + 1])] : nil;
+    }
+    switch (tag) {
+    case TagNull:
+        return [NSNull null];
+    case TagFalse:
+        return [NSNumber numberWithBool:NO];
+    case TagTrue:
+        return [NSNumber numberWithBool:YES];
+    case TagInt:
+        if (offset + 9 <= _length) {
+            return [NSNumber numberWithLongLong:(int64_t)ReadUInt64(&_bytes[offset + 1])];
+        }
+        break;
+    case TagDouble:
+        if (offset + 9 <= _length) {
+            uint64_t bits = ReadUInt64(&_bytes[offset + 1]);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return [NSNumber numberWithDouble:value];
+        }
+        break;
+    case TagArray:
+    case TagObject:
+        if (offset + ContainerHeaderSize <= _length) {
+            uint32_t count = ReadUInt32(&_bytes[offset + 1]);
+            NSUInteger entrySize = (tag == TagArray) ? ArrayEntrySize : ObjectEntrySize;
+            if ((NSUInteger)offset + ContainerHeaderSize + (count * entrySize) <= _length) {
+                if (tag == TagArray) {
+                    return [[SCCompiledJSONArray alloc] initWithJSON:self offset:offset count:count];
+                }
+                return [[SCCompiledJSONObject alloc] initWithJSON:self offset:offset count:count];
+            }
+        }
+        break;
+    }
+    return nil;
+}
+
+- (SCCompiledJSONPrefix)prefixOfValueAtOffset:(uint32_t)offset {
+    if (offset >= _length) {
+        return SCCompiledJSONPrefixNone;
+    }
+    uint8_t tag = _bytes[offset];
+    if ((tag & 0xF0) != TagString || (tag & 0x0F) > MaxPrefixClass) {
+        return SCCompiledJSONPrefixNone;
+    }
+    return (SCCompiledJSONPrefix)(tag & 0x0F);
+}
+
+- (NSString *)stringAtIndex:(uint32_t)idx {
+    if (idx >= _stringCount) {
+        return nil;
+    }
+    NSString *string = SlotValue(&_strings[idx]);
+    if (!string) {
+        const uint8_t *entry = &_bytes[_stringTableOffset + 4 + (idx * 8)];
+        uint32_t offset = ReadUInt32(entry);
+        uint32_t length = ReadUInt32(entry + 4);
+        if ((NSUInteger)offset + length <= _length) {
+            string = [[NSString alloc] initWithBytes:&_bytes[offset]
+                                              length:length
+                                            encoding:NSUTF8StringEncoding];
+            // Two threads may decode the same string at once; both get the instance stored first.
+            string = StoreSlotValue(&_strings[idx], string);
+        }
+    }
+    return string;
+}
+
+- (NSString *)keyAtIndex:(uint32_t)idx ofObjectAtOffset:(uint32_t)offset {
+    const uint8_t *entry = &_bytes[offset + ContainerHeaderSize + (idx * ObjectEntrySize)];
+    return [self stringAtIndex:ReadUInt32(entry)];
+}
+
+- (uint32_t)valueOffsetOfEntry:(uint32_t)idx ofObjectAtOffset:(uint32_t)offset {
+    const uint8_t *entry = &_bytes[offset + ContainerHeaderSize + (idx * ObjectEntrySize)];
+    return ReadUInt32(entry + 4);
+}
+
+- (NSUInteger)indexOfKey:(NSString *)key ofObjectAtOffset:(uint32_t)offset count:(uint32_t)count {
+    if (![key isKindOfClass:[NSString class]]) {
+        return NSNotFound;
+    }
+    const char *keyBytes = [key UTF8String];
+    size_t keyLength = strlen(keyBytes);
+    const uint8_t *entries = &_bytes[offset + ContainerHeaderSize];
+    // Object entries are sorted by key bytes, so do a binary search for the key.
+    NSInteger low = 0, high = (NSInteger)count - 1;
+    while (low <= high) {
+        NSInteger mid = (low + high) / 2;
+        const uint8_t *entry = &entries[mid * ObjectEntrySize];
+        uint32_t keyIdx = ReadUInt32(entry);
+        if (keyIdx >= _stringCount) {
+            return NSNotFound;
+        }
+        const uint8_t *stringEntry = &_bytes[_stringTableOffset + 4 + (keyIdx * 8)];
+        uint32_t stringOffset = ReadUInt32(stringEntry);
+        uint32_t stringLength = ReadUInt32(stringEntry + 4);
+        if ((NSUInteger)stringOffset + stringLength > _length) {
+            return NSNotFound;
+        }
+        int cmp = memcmp(&_bytes[stringOffset], keyBytes, MIN(stringLength, keyLength));
+        if (cmp == 0) {
+            cmp = (stringLength < keyLength) ? -1 : (stringLength > keyLength ? 1 : 0);
+        }
+        if (cmp == 0) {
+            return (NSUInteger)mid;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid - 1;
+        }
+    }
+    return NSNotFound;
+}
+
+- (uint32_t)offsetOfItem:(uint32_t)idx ofArrayAtOffset:(uint32_t)offset {
+    const uint8_t *entry = &_bytes[offset + ContainerHeaderSize + (idx * ArrayEntrySize)];
+    return ReadUInt32(entry);
+}
+
+#pragma mark - Class methods
+
++ (BOOL)isCompiledJSONData:(NSData *)data {
+    return [data isKindOfClass:[NSData class]]
+        && [data length] >= SCCompiledJSONHeaderSize
+        && memcmp([data bytes], SCCompiledJSONMagic, 4) == 0;
+}
+
++ (id)JSONObjectWithContentsOfFile:(NSString *)path {
+    NSError *error = nil;
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedAlways error:&error];
+    if (error) {
+        [SCLogger withTag:@"SCCompiledJSON" error:@"Reading %@: %@", path, error];
+        return nil;
+    }
+    return [[[SCCompiledJSON alloc] initWithData:data] rootValue];
+}
+
++ (NSString *)compiledPathForPath:(NSString *)path {
+    return [[path stringByDeletingPathExtension] stringByAppendingPathExtension:SCCompiledJSONFileExtension];
+}
+
+@end
+
+@implementation SCCompiledJSONObject
+
+- (id)initWithJSON:(SCCompiledJSON *)json offset:(uint32_t)offset count:(uint32_t)count {
+    self = [super init];
+    if (self) {
+        _json = json;
+        _offset = offset;
+        _count = count;
+        _values = AllocSlots(count);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    FreeSlots(_values, _count);
+}
+
+/// Return the value of the nth entry, decoding it on first access.
+- (id)valueAtIndex:(uint32_t)idx {
+    id value = SlotValue(&_values[idx]);
+    if (!value) {
+        value = [_json valueAtOffset:[_json valueOffsetOfEntry:idx ofObjectAtOffset:_offset]];
+        value = StoreSlotValue(&_values[idx], value);
+    }
+    return value;
+}
+
+- (NSString *)keyAtIndex:(uint32_t)idx {
+    return [_json keyAtIndex:idx ofObjectAtOffset:_offset];
+}
+
+- (NSUInteger)count {
+    return _count;
+}
+
+- (id)objectForKey:(id)aKey {
+    NSUInteger idx = [_json indexOfKey:aKey ofObjectAtOffset:_offset count:_count];
+    return idx == NSNotFound ? nil : [self valueAtIndex:(uint32_t)idx];
+}
+
+- (NSEnumerator *)keyEnumerator {
+    return [[SCCompiledJSONKeyEnumerator alloc] initWithObject:self count:_count];
+}
+
+- (id)valueForKeyComponent:(NSString *)key prefix:(SCCompiledJSONPrefix *)prefix {
+    NSUInteger idx = [_json indexOfKey:key ofObjectAtOffset:_offset count:_count];
+    if (idx == NSNotFound) {
+        *prefix = SCCompiledJSONPrefixNone;
+        return nil;
+    }
+    *prefix = [_json prefixOfValueAtOffset:[_json valueOffsetOfEntry:(uint32_t)idx ofObjectAtOffset:_offset]];
+    return [self valueAtIndex:(uint32_t)idx];
+}
+
+@end
+
+@implementation SCCompiledJSONArray
+
+- (id)initWithJSON:(SCCompiledJSON *)json offset:(uint32_t)offset count:(uint32_t)count {
+    self = [super init];
+    if (self) {
+        _json = json;
+        _offset = offset;
+        _count = count;
+        _values = AllocSlots(count);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    FreeSlots(_values, _count);
+}
+
+/// Return the nth item, decoding it on first access.
+- (id)valueAtIndex:(uint32_t)idx {
+    id value = SlotValue(&_values[idx]);
+    if (!value) {
+        value = [_json valueAtOffset:[_json offsetOfItem:idx ofArrayAtOffset:_offset]];
+        // NSArray items can't be nil, so represent unreadable items as null.
+        value = StoreSlotValue(&_values[idx], value ? value : [NSNull null]);
+    }
+    return value;
+}
+
+- (NSUInteger)count {
+    return _count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"Index %lu beyond bounds [0 .. %lu]", (unsigned long)index, (unsigned long)_count];
+    }
+    return [self valueAtIndex:(uint32_t)index];
+}
+
+- (id)valueForKeyComponent:(NSString *)key prefix:(SCCompiledJSONPrefix *)prefix {
+    *prefix = SCCompiledJSONPrefixNone;
+    NSInteger idx = [key integerValue];
+    if (idx < 0 || idx >= (NSInteger)_count) {
+        return nil;
+    }
+    *prefix = [_json prefixOfValueAtOffset:[_json offsetOfItem:(uint32_t)idx ofArrayAtOffset:_offset]];
+    return [self valueAtIndex:(uint32_t)idx];
+}
+
+@end
+
+@implementation SCCompiledJSONKeyEnumerator
+
+- (id)initWithObject:(SCCompiledJSONObject *)object count:(uint32_t)count {
+    self = [super init];
+    if (self) {
+        _object = object;
+        _count = count;
+    }
+    return self;
+}
+
+- (id)nextObject {
+    while (_index < _count) {
+        NSString *key = [_object keyAtIndex:_index++];
+        if (key) {
+            return key;
+        }
+    }
+    return nil;
+}
+
+@end
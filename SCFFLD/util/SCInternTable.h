@@ -0,0 +1,65 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A table of interned strings.
+ * Large configurations repeat the same property names and short values many times over,
+ * and each occurrence is a separate string instance after JSON parsing. Interning the
+ * strings replaces each occurrence with a single shared instance, which reduces heap use
+ * and allows pointer equality tests on interned values.
+ *
+ * Tables are intended to be used for a single configuration load and then discarded, so
+ * the strings in a table don't outlive the configuration which uses them. A table isn't
+ * thread safe.
+ */
+@interface SCInternTable : NSObject {
+    /// The set of interned strings.
+    NSMutableSet *_strings;
+    /// The number of intern lookups performed.
+    NSUInteger _lookups;
+    /// The number of lookups which returned an existing string.
+    NSUInteger _hits;
+    /// The total length, in characters, of the looked up strings which matched an existing string.
+    NSUInteger _duplicateCharacters;
+}
+
+/**
+ * The maximum length of values interned by _internJSONData:_.
+ * Object keys are always interned. Defaults to 64.
+ */
+@property (nonatomic, assign) NSUInteger maxValueLength;
+
+/// Return the interned instance of a string.
+- (NSString *)intern:(NSString *)string;
+/**
+ * Intern the object keys and short string values of parsed JSON data, in place.
+ * The data must have been parsed with mutable containers (i.e. using the
+ * _NSJSONReadingMutableContainers_ option); containers are updated rather than copied.
+ */
+- (void)internJSONData:(id)data;
+/**
+ * Return statistics for the table.
+ * Includes the number of strings in the table (_strings_), the number of lookups (_lookups_),
+ * the number of lookups which found an existing string (_hits_) and the total length of the
+ * strings found in the table (_duplicateCharacters_).
+ */
+- (NSDictionary *)statistics;
+
+@end
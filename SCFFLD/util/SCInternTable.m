@@ -0,0 +1,111 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+
+#import "SCInternTable.h"
+
+@interface SCInternTable ()
+
+/// Intern a parsed JSON value; returns the interned instance of short strings.
+- (id)internValue:(id)value;
+/// Intern a string.
+- (NSString *)internString:(NSString *)string;
+
+@end
+
+@implementation SCInternTable
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _strings = [NSMutableSet new];
+        _maxValueLength = 64;
+    }
+    return self;
+}
+
+- (NSString *)intern:(NSString *)string {
+    return string ? [self internString:string] : nil;
+}
+
+- (void)internJSONData:(id)data {
+    [self internValue:data];
+}
+
+- (NSDictionary *)statistics {
+    return @{
+        @"strings":             [NSNumber numberWithUnsignedInteger:[_strings count]],
+        @"lookups":             [NSNumber numberWithUnsignedInteger:_lookups],
+        @"hits":                [NSNumber numberWithUnsignedInteger:_hits],
+        @"duplicateCharacters": [NSNumber numberWithUnsignedInteger:_duplicateCharacters]
+    };
+}
+
+#pragma mark - Private methods
+
+- (id)internValue:(id)value {
+    if ([value isKindOfClass:[NSString class]]) {
+        NSString *string = (NSString *)value;
+        return [string length] <= _maxValueLength ? [self internString:string] : string;
+    }
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        NSMutableDictionary *dictionary = (NSMutableDictionary *)value;
+        // Copy the keys, as the dictionary is modified while they're iterated.
+        for (id key in [dictionary allKeys]) {
+            id item = dictionary[key];
+            id internedItem = [self internValue:item];
+            id internedKey = [key isKindOfClass:[NSString class]] ? [self internString:(NSString *)key] : key;
+            if (internedKey != key) {
+                // Setting a value doesn't replace an equal key, so remove the entry first.
+                [dictionary removeObjectForKey:key];
+                dictionary[internedKey] = internedItem;
+            }
+            else if (internedItem != item) {
+                dictionary[key] = internedItem;
+            }
+        }
+        return dictionary;
+    }
+    if ([value isKindOfClass:[NSArray class]]) {
+        NSMutableArray *array = (NSMutableArray *)value;
+        NSUInteger count = [array count];
+        for (NSUInteger idx = 0; idx < count; idx++) {
+            id item = array[idx];
+            id internedItem = [self internValue:item];
+            if (internedItem != item) {
+                [array replaceObjectAtIndex:idx withObject:internedItem];
+            }
+        }
+        return array;
+    }
+    return value;
+}
+
+- (NSString *)internString:(NSString *)string {
+    _lookups++;
+    NSString *interned = [_strings member:string];
+    if (interned) {
+        _hits++;
+        _duplicateCharacters += [string length];
+        return interned;
+    }
+    interned = [string copy];
+    [_strings addObject:interned];
+    return interned;
+}
+
+@end
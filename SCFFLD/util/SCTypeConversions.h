@@ -18,6 +18,34 @@
 
 #import <UIKit/UIKit.h>
 
+@class SCInternTable;
+
+/**
+ * Value representation identifiers.
+ * Each identifier corresponds to a representation name; see _value:asRepresentation:_.
+ */
+typedef NS_ENUM(NSInteger, SCRepresentation) {
+    /// An unrecognized representation name.
+    SCRepresentationUnknown = 0,
+    SCRepresentationRaw,
+    SCRepresentationConfiguration,
+    SCRepresentationString,
+    SCRepresentationNumber,
+    SCRepresentationBoolean,
+    SCRepresentationDate,
+    SCRepresentationURL,
+    SCRepresentationData,
+    SCRepresentationImage,
+    SCRepresentationJSON,
+    SCRepresentationDefault,
+    SCRepresentationFilePath,
+    /// The identifier assigned to the first custom representation.
+    SCRepresentationFirstCustom
+};
+
+/// A block for converting a value to a custom representation.
+typedef id (^SCRepresentationConverter) (id value);
+
 /**
  * Standard type conversions.
  */
@@ -97,8 +125,14 @@
  * looks like JSON data. If so, then it attempts parsing the string and returning the result.
  * If the JSON parse fails, or if the string doesn't look like JSON, then the initial value is returned
  * as it.
+ * Compiled JSON data is read lazily; _nil_ is returned if the compiled data isn't valid.
  */
 + (id)asJSONData:(id)value;
+/**
+ * Convert the value to parsed JSON data, interning the keys and short string values of the result.
+ * @param internTable   A table to intern strings with; or _nil_ to leave strings as parsed.
+ */
++ (id)asJSONData:(id)value internTable:(SCInternTable *)internTable;
    
 /**
  * Convert a value to the named representation.
@@ -112,9 +146,35 @@
  * - image
  * - json
  * - default (returns the unchanged value).
+ * Custom representations added with _registerRepresentation:converter:_ are also recognized.
  * @return Returns the value with the type conversion for the specified representation applied.
  * Returns _nil_ if the representation name isn't recognized.
  */
 + (id)value:(id)value asRepresentation:(NSString *)name;
 
+/**
+ * Convert a value to the identified representation.
+ * Standard representations are converted as described for _value:asRepresentation:_; custom
+ * representations are converted using their registered converter.
+ * Note that _raw_, _configuration_ and _filepath_ aren't supported by this method, and return _nil_.
+ */
++ (id)value:(id)value asRepresentationType:(SCRepresentation)representation;
+
+/// Return the identifier for a representation name; returns _SCRepresentationUnknown_ if not recognized.
++ (SCRepresentation)representationForName:(NSString *)name;
+
+/// Return the name of an identified representation.
++ (NSString *)nameForRepresentation:(SCRepresentation)representation;
+
+/**
+ * Register a custom representation.
+ * Custom representations should be registered at app startup, before any configurations are read.
+ * @param name      The representation name.
+ * @param converter A block for converting values to the representation.
+ * @return The representation's identifier. If _name_ is already registered then its existing
+ * identifier is returned; the converter of a custom representation is replaced, but the standard
+ * representations can't be redefined. Returns _SCRepresentationUnknown_ if _name_ is nil or empty.
+ */
++ (SCRepresentation)registerRepresentation:(NSString *)name converter:(SCRepresentationConverter)converter;
+
 @end
@@ -20,7 +20,10 @@
 #import "SCRegExp.h"
 #import "ISO8601DateFormatter.h"
 #import "SCLogger.h"
+#import "SCCompiledJSON.h"
+#import "SCInternTable.h"
 #import "objc/runtime.h"
+#import <pthread.h>
 
 #define Retina4DisplayHeight    568
 #define IsIPhone                ([[UIDevice currentDevice] userInterfaceIdiom] == UIUserInterfaceIdiomPhone)
@@ -28,6 +31,15 @@
 #define IsString(v)             ([v isKindOfClass:[NSString class]])
 #define IsNumber(v)             ([v isKindOfClass:[NSNumber class]])
 
+// Representation names, indexed by representation identifier.
+static NSArray *SCTypeConversions_representationNames;
+// Representation identifiers, keyed by name.
+static NSDictionary *SCTypeConversions_representations;
+// Custom representation converters, keyed by identifier.
+static NSDictionary *SCTypeConversions_converters;
+// Lock guarding the representation registries; lookups take a read lock so can run concurrently.
+static pthread_rwlock_t SCTypeConversions_registryLock = PTHREAD_RWLOCK_INITIALIZER;
+
 @implementation SCTypeConversions
 
 + (NSString *)asString:(id)value {
@@ -144,7 +156,20 @@ static void *SCTypeConversions_threadDateFormatter;
 }
 
 + (id)asJSONData:(id)value {
+    return [SCTypeConversions asJSONData:value internTable:nil];
+}
+
++ (id)asJSONData:(id)value internTable:(SCInternTable *)internTable {
     id jsonData;
+    if ([SCCompiledJSON isCompiledJSONData:value]) {
+        // Compiled JSON is read lazily from the data.
+        jsonData = [[[SCCompiledJSON alloc] initWithData:(NSData *)value] rootValue];
+        if (!jsonData) {
+            // Don't return the compiled bytes to callers expecting JSON data.
+            [SCLogger withTag:@"SCTypeConversions" error:@"Invalid compiled JSON data (%lu bytes)", (unsigned long)[(NSData *)value length]];
+        }
+        return jsonData;
+    }
     if ([value isKindOfClass:[NSData class]]) {
         value = [[NSString alloc] initWithData:(NSData *)value encoding:NSUTF8StringEncoding];
     }
@@ -152,11 +177,17 @@ static void *SCTypeConversions_threadDateFormatter;
         if ([SCRegExp pattern:@"^\\s*([{\\[\"\\d]|true|false)" matches:value]) {
             NSError *error = nil;
             NSData *data = [SCTypeConversions asData:value];
-            jsonData = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
+            // Interning replaces strings in place, so needs mutable containers.
+            NSJSONReadingOptions options = internTable ? NSJSONReadingMutableContainers : 0;
+            jsonData = [NSJSONSerialization JSONObjectWithData:data options:options error:&error];
             if (error) {
                 [SCLogger withTag:@"SCTypeConversions" error:@"Parsing JSON %@\n%@", value, error];
                 jsonData = value;
             }
+            else if (internTable) {
+                // Replace repeated keys and short values with shared instances.
+                [internTable internJSONData:jsonData];
+            }
         }
         else {
             jsonData = value;
@@ -169,32 +200,105 @@ static void *SCTypeConversions_threadDateFormatter;
 }
 
 + (id)value:(id)value asRepresentation:(NSString *)name {
-    if ([@"string" isEqualToString:name]) {
+    return [SCTypeConversions value:value asRepresentationType:[SCTypeConversions representationForName:name]];
+}
+
++ (id)value:(id)value asRepresentationType:(SCRepresentation)representation {
+    switch (representation) {
+    case SCRepresentationString:
         return [SCTypeConversions asString:value];
-    }
-    if ([@"number" isEqualToString:name] || [@"boolean" isEqualToString:name]) {
+    case SCRepresentationNumber:
+    case SCRepresentationBoolean:
         return [SCTypeConversions asNumber:value];
-    }
-    if ([@"date" isEqualToString:name]) {
+    case SCRepresentationDate:
         return [SCTypeConversions asDate:value];
-    }
-    if ([@"url" isEqualToString:name]) {
+    case SCRepresentationURL:
         return [SCTypeConversions asURL:value];
-    }
-    if ([@"data" isEqualToString:name]) {
+    case SCRepresentationData:
         return [SCTypeConversions asData:value];
-    }
-    if ([@"image" isEqualToString:name]) {
+    case SCRepresentationImage:
         return [SCTypeConversions asImage:value];
-    }
-    if ([@"json" isEqualToString:name]) {
+    case SCRepresentationJSON:
         return [SCTypeConversions asJSONData:value];
-    }
-    if ([@"default" isEqualToString:name]) {
+    case SCRepresentationDefault:
         return value;
+    case SCRepresentationUnknown:
+    case SCRepresentationRaw:
+    case SCRepresentationConfiguration:
+    case SCRepresentationFilePath:
+        // Representation not supported, so return nil.
+        return nil;
+    default:
+        break;
+    }
+    // Custom representation. Registries are copied on write, so the converter can be called
+    // after the lock is released.
+    pthread_rwlock_rdlock(&SCTypeConversions_registryLock);
+    SCRepresentationConverter converter = SCTypeConversions_converters[[NSNumber numberWithInteger:representation]];
+    pthread_rwlock_unlock(&SCTypeConversions_registryLock);
+    return converter ? converter(value) : nil;
+}
+
++ (SCRepresentation)representationForName:(NSString *)name {
+    if (!name) {
+        return SCRepresentationUnknown;
+    }
+    pthread_rwlock_rdlock(&SCTypeConversions_registryLock);
+    NSNumber *representation = SCTypeConversions_representations[name];
+    pthread_rwlock_unlock(&SCTypeConversions_registryLock);
+    return representation ? (SCRepresentation)[representation integerValue] : SCRepresentationUnknown;
+}
+
++ (NSString *)nameForRepresentation:(SCRepresentation)representation {
+    pthread_rwlock_rdlock(&SCTypeConversions_registryLock);
+    NSArray *names = SCTypeConversions_representationNames;
+    pthread_rwlock_unlock(&SCTypeConversions_registryLock);
+    return (representation > SCRepresentationUnknown && (NSUInteger)representation < [names count]) ? names[representation] : nil;
+}
+
++ (SCRepresentation)registerRepresentation:(NSString *)name converter:(SCRepresentationConverter)converter {
+    if ([name length] == 0) {
+        [SCLogger withTag:@"SCTypeConversions" error:@"Can't register a representation without a name"];
+        return SCRepresentationUnknown;
+    }
+    pthread_rwlock_wrlock(&SCTypeConversions_registryLock);
+    NSNumber *existing = SCTypeConversions_representations[name];
+    SCRepresentation representation;
+    if (existing) {
+        representation = (SCRepresentation)[existing integerValue];
+    }
+    else {
+        // Registries are copied on write, so that readers can use a registry after unlocking.
+        representation = [SCTypeConversions_representationNames count];
+        SCTypeConversions_representationNames = [SCTypeConversions_representationNames arrayByAddingObject:name];
+        NSMutableDictionary *representations = [SCTypeConversions_representations mutableCopy];
+        representations[name] = [NSNumber numberWithInteger:representation];
+        SCTypeConversions_representations = representations;
+    }
+    if (representation >= SCRepresentationFirstCustom && converter) {
+        NSMutableDictionary *converters = [SCTypeConversions_converters mutableCopy];
+        converters[[NSNumber numberWithInteger:representation]] = [converter copy];
+        SCTypeConversions_converters = converters;
+    }
+    pthread_rwlock_unlock(&SCTypeConversions_registryLock);
+    return representation;
+}
+
++ (void)initialize {
+    if (self == [SCTypeConversions class]) {
+        // Standard representation names, in SCRepresentation order.
+        NSArray *names = @[
+            @"", @"raw", @"configuration", @"string", @"number", @"boolean", @"date", @"url",
+            @"data", @"image", @"json", @"default", @"filepath"
+        ];
+        NSMutableDictionary *representations = [NSMutableDictionary new];
+        for (NSInteger idx = SCRepresentationRaw; idx < [names count]; idx++) {
+            representations[names[idx]] = [NSNumber numberWithInteger:idx];
+        }
+        SCTypeConversions_representationNames = names;
+        SCTypeConversions_representations = representations;
+        SCTypeConversions_converters = @{};
     }
-    // Representation name not recognized, so return nil.
-    return nil;
 }
 
 @end
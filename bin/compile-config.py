@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+#
+# Compile SCFFLD JSON configuration files to the compiled JSON format read by SCCompiledJSON.
+#
+# Usage:
+#   compile-config.py <file or directory> [<file or directory> ...]
+#
+# Each .json file found is compiled to a .cjson file in the same location. Directories are
+# searched recursively. Intended to be run from an Xcode Run Script build phase after resources
+# have been copied, e.g.:
+#
+#   python3 "${PODS_ROOT}/SCFFLD/bin/compile-config.py" \
+#       "${TARGET_BUILD_DIR}/${UNLOCALIZED_RESOURCES_FOLDER_PATH}/SCFFLD"
+#
+# See SCFFLD/util/SCCompiledJSON.h for a description of the file format.
+
+import json
+import os
+import struct
+import sys
+
+MAGIC = b'SCJB'
+VERSION = 1
+
+TAG_NULL = 0x00
+TAG_FALSE = 0x01
+TAG_TRUE = 0x02
+TAG_INT = 0x03
+TAG_DOUBLE = 0x04
+TAG_STRING = 0x10
+TAG_ARRAY = 0x20
+TAG_OBJECT = 0x21
+
+# Configuration value prefixes, in prefix class order; see SCIOCConfiguration.
+PREFIXES = '$?>@#`'
+
+HEADER_SIZE = 16
+
+
+class Compiler:
+
+    def __init__(self):
+        self.strings = []
+        self.string_idxs = {}
+        self.out = bytearray(HEADER_SIZE)
+
+    def intern(self, s):
+        idx = self.string_idxs.get(s)
+        if idx is None:
+            idx = len(self.strings)
+            self.strings.append(s)
+            self.string_idxs[s] = idx
+        return idx
+
+    def write_value(self, value):
+        """Write a value and return its offset."""
+        offset = len(self.out)
+        if value is None:
+            self.out.append(TAG_NULL)
+        elif value is True:
+            self.out.append(TAG_TRUE)
+        elif value is False:
+            self.out.append(TAG_FALSE)
+        elif isinstance(value, int) and -2**63 <= value < 2**63:
+            self.out += struct.pack('<Bq', TAG_INT, value)
+        elif isinstance(value, (int, float)):
+            self.out += struct.pack('<Bd', TAG_DOUBLE, float(value))
+        elif isinstance(value, str):
+            prefix_class = PREFIXES.find(value[0]) + 1 if value else 0
+            self.out += struct.pack('<BI', TAG_STRING | prefix_class, self.intern(value))
+        elif isinstance(value, list):
+            self.write_array(value)
+        elif isinstance(value, dict):
+            self.write_object(value)
+        else:
+            raise TypeError('Unsupported value type: %s' % type(value))
+        return offset
+
+    def write_array(self, items):
+        header = len(self.out)
+        self.out += struct.pack('<BII', TAG_ARRAY, len(items), 0)
+        table = len(self.out)
+        self.out += bytes(4 * len(items))
+        for i, item in enumerate(items):
+            struct.pack_into('<I', self.out, table + 4 * i, self.write_value(item))
+        struct.pack_into('<I', self.out, header + 5, len(self.out))
+
+    def write_object(self, obj):
+        # Entries are sorted by the UTF-8 bytes of their keys, so that readers can binary search.
+        keys = sorted(obj.keys(), key=lambda k: k.encode('utf-8'))
+        header = len(self.out)
+        self.out += struct.pack('<BII', TAG_OBJECT, len(keys), 0)
+        table = len(self.out)
+        self.out += bytes(8 * len(keys))
+        for i, key in enumerate(keys):
+            struct.pack_into('<II', self.out, table + 8 * i, self.intern(key), self.write_value(obj[key]))
+        struct.pack_into('<I', self.out, header + 5, len(self.out))
+
+    def compile(self, root):
+        root_offset = self.write_value(root)
+        # Write the string table: a count, followed by an offset/length pair for each string,
+        # followed by the string bytes.
+        encoded = [s.encode('utf-8') for s in self.strings]
+        string_table = len(self.out)
+        self.out += struct.pack('<I', len(encoded))
+        data_offset = len(self.out) + 8 * len(encoded)
+        for s in encoded:
+            self.out += struct.pack('<II', data_offset, len(s))
+            data_offset += len(s)
+        for s in encoded:
+            self.out += s
+        struct.pack_into('<4sB3xII', self.out, 0, MAGIC, VERSION, string_table, root_offset)
+        return bytes(self.out)
+
+
+def compile_file(path):
+    with open(path, 'rb') as f:
+        data = json.loads(f.read().decode('utf-8'))
+    compiled = Compiler().compile(data)
+    out_path = os.path.splitext(path)[0] + '.cjson'
+    with open(out_path, 'wb') as f:
+        f.write(compiled)
+    return out_path, os.path.getsize(path), len(compiled)
+
+
+def main(args):
+    if not args:
+        sys.stderr.write('Usage: compile-config.py <file or directory> ...\n')
+        return 1
+    paths = []
+    for arg in args:
+        if os.path.isdir(arg):
+            for dirpath, dirnames, filenames in os.walk(arg):
+                paths += [os.path.join(dirpath, f) for f in sorted(filenames) if f.endswith('.json')]
+        else:
+            paths.append(arg)
+    for path in paths:
+        try:
+            out_path, json_size, compiled_size = compile_file(path)
+            print('%s -> %s (%d -> %d bytes)' % (path, out_path, json_size, compiled_size))
+        except (ValueError, TypeError) as e:
+            sys.stderr.write('Error compiling %s: %s\n' % (path, e))
+            return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,56 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+#import "SCArrayConfigurationBenchmark.h"
+#import "SCIOCConfiguration.h"
+
+/// The number of items in the benchmark array.
+#define ItemCount (10000)
+
+@implementation SCArrayConfigurationBenchmark
+
++ (void)run {
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:ItemCount];
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:ItemCount];
+    for (NSUInteger i = 0; i < ItemCount; i++) {
+        [items addObject:[NSString stringWithFormat:@"item %lu", (unsigned long)i]];
+        [keys addObject:[NSString stringWithFormat:@"%lu", (unsigned long)i]];
+    }
+    SCIOCConfiguration *config = [[SCIOCConfiguration alloc] initWithData:items];
+    NSDictionary *data = config.configData;
+    __block NSUInteger found = 0;
+    // Direct lookups on the array backed dictionary.
+    [SCBenchmark measure:@"Array config objectForKey: (10k keys)" iterations:100 block:^(NSUInteger i) {
+        for (NSString *key in keys) {
+            found += [data objectForKey:key] != nil;
+        }
+    }];
+    // Lookups through the configuration API.
+    [SCBenchmark measure:@"Array config getValueAsString: (10k keys)" iterations:100 block:^(NSUInteger i) {
+        for (NSString *key in keys) {
+            found += [config getValueAsString:key] != nil;
+        }
+    }];
+    // Full key enumeration.
+    [SCBenchmark measure:@"Array config key enumeration (10k keys)" iterations:100 block:^(NSUInteger i) {
+        for (NSString *key in data) {
+            found += [key length] > 0;
+        }
+    }];
+    NSLog(@"%lu values found", (unsigned long)found);
+}
+
+@end
@@ -0,0 +1,37 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+#import <Foundation/Foundation.h>
+
+/**
+ * A minimal benchmark runner.
+ * The benchmarks in this directory aren't part of any target; to run them, add them and the SCFFLD
+ * sources to an app or test target and call each benchmark's _run_ method, e.g. from the app
+ * delegate's application:didFinishLaunchingWithOptions:. Build in release configuration, and run on
+ * a device, for representative results.
+ */
+@interface SCBenchmark : NSObject
+
+/**
+ * Run a block a number of times, and log the mean time per iteration.
+ * @param name          The benchmark name.
+ * @param iterations    The number of times to run the block.
+ * @param block         The block to run; passed the iteration index.
+ * @return The mean time per iteration, in nanoseconds.
+ */
++ (double)measure:(NSString *)name iterations:(NSUInteger)iterations block:(void (^)(NSUInteger i))block;
+
+@end
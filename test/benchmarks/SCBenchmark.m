@@ -0,0 +1,38 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+#import "SCBenchmark.h"
+#import <mach/mach_time.h>
+
+@implementation SCBenchmark
+
++ (double)measure:(NSString *)name iterations:(NSUInteger)iterations block:(void (^)(NSUInteger i))block {
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    uint64_t start = mach_absolute_time();
+    for (NSUInteger i = 0; i < iterations; i++) {
+        @autoreleasepool {
+            block(i);
+        }
+    }
+    uint64_t elapsed = mach_absolute_time() - start;
+    double nanos = (double)elapsed * timebase.numer / timebase.denom;
+    double mean = iterations > 0 ? nanos / iterations : 0.0;
+    NSLog(@"%@: %lu iterations, %.3f ms total, %.1f ns/iteration", name, (unsigned long)iterations, nanos / 1e6, mean);
+    return mean;
+}
+
+@end
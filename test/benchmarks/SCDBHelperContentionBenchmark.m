@@ -0,0 +1,108 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCDBHelperContentionBenchmark.h"
+
+/// The number of rows in the benchmark table.
+#define RowCount (1000)
+/// The number of point reads measured.
+#define ReadCount (20000)
+/// The number of rows updated by each write transaction.
+#define RowsPerWrite (50)
+
+@interface SCDBHelperContentionBenchmark ()
+
+/// A flag telling the writer thread to stop.
+@property (atomic, assign) BOOL stopWriting;
+
+/// Measure reads during writes, with the specified journal mode.
+- (void)measureWithWALMode:(BOOL)walMode;
+
+@end
+
+@implementation SCDBHelperContentionBenchmark
+
++ (void)run {
+    SCDBHelperContentionBenchmark *benchmark = [SCDBHelperContentionBenchmark new];
+    [benchmark measureWithWALMode:NO];
+    [benchmark measureWithWALMode:YES];
+}
+
+- (void)measureWithWALMode:(BOOL)walMode {
+    NSString *name = walMode ? @"SCDBHelperContentionBenchmarkWAL" : @"SCDBHelperContentionBenchmark";
+    SCDBHelper *helper = [[SCDBHelper alloc] initWithName:name version:1];
+    helper.delegate = self;
+    helper.walMode = walMode;
+    [helper deleteDatabase];
+    if (![helper openDatabase]) {
+        NSLog(@"Unable to open benchmark database %@", name);
+        return;
+    }
+    // Write continuously on a background thread until the reads are done.
+    self.stopWriting = NO;
+    __block NSUInteger writes = 0;
+    dispatch_group_t writer = dispatch_group_create();
+    dispatch_group_async(writer, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        while (!self.stopWriting) {
+            [helper performWrite:^(SCSqliteDB *db) {
+                NSError *error = nil;
+                [db beginTransaction:&error];
+                for (NSUInteger i = 0; i < RowsPerWrite; i++) {
+                    NSArray *params = @[ @(writes * 0.5), @((writes * RowsPerWrite + i) % RowCount) ];
+                    [db executeUpdate:@"UPDATE t SET value = ? WHERE id = ?" parameters:params error:&error];
+                }
+                [db commitTransaction:&error];
+            }];
+            writes++;
+        }
+    });
+    __block NSUInteger found = 0;
+    NSString *label = [NSString stringWithFormat:@"Point read during writes, %@ (20k reads)", walMode ? @"WAL" : @"rollback journal"];
+    [SCBenchmark measure:label iterations:ReadCount block:^(NSUInteger i) {
+        [helper performRead:^(SCSqliteDB *db) {
+            NSError *error = nil;
+            SCSqliteResultSet *rs = [db executeQuery:@"SELECT * FROM t WHERE id = ?" parameters:@[ @((i * 7919) % RowCount) ] error:&error];
+            if ([rs next]) {
+                found++;
+            }
+            [rs close];
+        }];
+    }];
+    self.stopWriting = YES;
+    dispatch_group_wait(writer, DISPATCH_TIME_FOREVER);
+    NSLog(@"%lu rows found, %lu write transactions", (unsigned long)found, (unsigned long)writes);
+    [helper deleteDatabase];
+}
+
+#pragma mark - SCDBHelperDelegate
+
+- (void)onCreate:(SCSqliteDB *)database error:(NSError **)error {
+    if (![database executeUpdate:@"CREATE TABLE t (id INTEGER PRIMARY KEY, name TEXT, value REAL)" error:error]) {
+        return;
+    }
+    for (NSUInteger i = 0; i < RowCount; i++) {
+        NSArray *params = @[ @(i), [NSString stringWithFormat:@"row %lu", (unsigned long)i], @(i * 0.5) ];
+        if (![database executeUpdate:@"INSERT INTO t (id, name, value) VALUES (?, ?, ?)" parameters:params error:error]) {
+            return;
+        }
+    }
+}
+
+- (void)onUpgrade:(SCSqliteDB *)database from:(NSInteger)oldVersion to:(NSInteger)newVersion error:(NSError **)error {
+}
+
+@end
@@ -0,0 +1,65 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCDBLiveQueryDiffBenchmark.h"
+#import "SCDBLiveQuery.h"
+
+/// The number of rows in each result.
+#define RowCount (1000)
+/// The number of diffs measured for each change.
+#define Iterations (1000)
+
+@implementation SCDBLiveQueryDiffBenchmark
+
++ (void)run {
+    NSMutableArray *rows = [[NSMutableArray alloc] initWithCapacity:RowCount];
+    for (NSUInteger i = 0; i < RowCount; i++) {
+        [rows addObject:@{ @"id": @(i), @"name": [NSString stringWithFormat:@"row %lu", (unsigned long)i], @"value": @(i * 0.5) }];
+    }
+    // An identical result, as when a write to an observed table doesn't affect the query.
+    NSArray *unchanged = [rows copy];
+    // A single updated row.
+    NSMutableArray *updated = [rows mutableCopy];
+    updated[RowCount / 2] = @{ @"id": @(RowCount / 2), @"name": @"updated", @"value": @(-1) };
+    // Ten rows moved from the start of the result to the end.
+    NSMutableArray *moved = [rows mutableCopy];
+    [moved removeObjectsInRange:NSMakeRange(0, 10)];
+    [moved addObjectsFromArray:[rows subarrayWithRange:NSMakeRange(0, 10)]];
+    // A tenth of the rows removed, and as many new rows inserted.
+    NSMutableArray *replaced = [NSMutableArray new];
+    for (NSUInteger i = 0; i < RowCount; i++) {
+        if (i % 10 == 0) {
+            [replaced addObject:@{ @"id": @(RowCount + i), @"name": @"inserted", @"value": @(i) }];
+        }
+        else {
+            [replaced addObject:rows[i]];
+        }
+    }
+    NSDictionary *changes = @{ @"unchanged": unchanged, @"one row updated": updated, @"10 rows moved": moved, @"10% replaced": replaced };
+    for (NSString *change in @[ @"unchanged", @"one row updated", @"10 rows moved", @"10% replaced" ]) {
+        NSArray *newRows = changes[change];
+        for (NSString *keyColumn in @[ @"id", [NSNull null] ]) {
+            NSString *key = [keyColumn isKindOfClass:[NSString class]] ? keyColumn : nil;
+            NSString *name = [NSString stringWithFormat:@"Diff 1k rows, %@, %@", change, key ? @"keyed" : @"whole rows"];
+            [SCBenchmark measure:name iterations:Iterations block:^(NSUInteger i) {
+                [SCDBLiveQueryDiff diffFromRows:rows toRows:newRows keyColumn:key];
+            }];
+        }
+    }
+}
+
+@end
@@ -0,0 +1,89 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCSqliteBulkInsertBenchmark.h"
+#import "SCSqlite.h"
+#import "NSArray+SC.h"
+
+/// The number of rows inserted by each iteration.
+#define RowCount (10000)
+/// The number of rows written by each multi-row statement; matches SCDB's default bulkInsertRowLimit.
+#define RowsPerStatement (100)
+/// The number of times each insert is repeated.
+#define Iterations (10)
+
+@implementation SCSqliteBulkInsertBenchmark
+
++ (void)run {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"SCSqliteBulkInsertBenchmark.sqlite"];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    NSError *error = nil;
+    SCSqliteDB *db = [[SCSqliteDB alloc] initWithDBPath:path error:&error];
+    if (error) {
+        NSLog(@"Opening %@: %@", path, error);
+        return;
+    }
+    if (![db executeUpdate:@"CREATE TABLE t (id INTEGER PRIMARY KEY, name TEXT, value REAL)" error:&error]) {
+        NSLog(@"Creating benchmark table: %@", error);
+        [db close];
+        return;
+    }
+    NSMutableArray *rows = [[NSMutableArray alloc] initWithCapacity:RowCount];
+    for (NSUInteger i = 0; i < RowCount; i++) {
+        [rows addObject:@[ @(i), [NSString stringWithFormat:@"row %lu", (unsigned long)i], @(i * 0.5) ]];
+    }
+    NSUInteger rowsPerStatement = MIN(RowsPerStatement, (NSUInteger)[db maxParameterCount] / 3);
+    NSString *multiRowSQL = [NSString stringWithFormat:@"INSERT INTO t (id, name, value) VALUES %@",
+                             [[NSArray arrayWithItem:@"(?, ?, ?)" repeated:rowsPerStatement] componentsJoinedByString:@", "]];
+    __block BOOL ok = YES;
+    // Each iteration empties the table first, so that both inserts write the same rows.
+    [SCBenchmark measure:@"Insert 10k rows, one statement per row" iterations:Iterations block:^(NSUInteger i) {
+        NSError *insertError = nil;
+        ok &= [db beginTransaction:&insertError];
+        ok &= [db executeUpdate:@"DELETE FROM t" error:&insertError];
+        for (NSArray *row in rows) {
+            ok &= [db executeUpdate:@"INSERT INTO t (id, name, value) VALUES (?, ?, ?)" parameters:row error:&insertError];
+        }
+        ok &= [db commitTransaction:&insertError];
+    }];
+    [SCBenchmark measure:@"Insert 10k rows, multi-row statements" iterations:Iterations block:^(NSUInteger i) {
+        NSError *insertError = nil;
+        ok &= [db beginTransaction:&insertError];
+        ok &= [db executeUpdate:@"DELETE FROM t" error:&insertError];
+        for (NSUInteger start = 0; start < RowCount; start += rowsPerStatement) {
+            NSUInteger count = MIN(rowsPerStatement, RowCount - start);
+            NSString *sql = multiRowSQL;
+            if (count < rowsPerStatement) {
+                sql = [NSString stringWithFormat:@"INSERT INTO t (id, name, value) VALUES %@",
+                       [[NSArray arrayWithItem:@"(?, ?, ?)" repeated:count] componentsJoinedByString:@", "]];
+            }
+            NSMutableArray *params = [[NSMutableArray alloc] initWithCapacity:count * 3];
+            for (NSUInteger idx = start; idx < start + count; idx++) {
+                [params addObjectsFromArray:rows[idx]];
+            }
+            ok &= [db executeUpdate:sql parameters:params error:&insertError];
+        }
+        ok &= [db commitTransaction:&insertError];
+    }];
+    if (!ok) {
+        NSLog(@"Bulk insert benchmark had write errors; results aren't valid");
+    }
+    [db close];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
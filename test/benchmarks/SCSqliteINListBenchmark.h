@@ -0,0 +1,28 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCBenchmark.h"
+
+/**
+ * Compares reading rows for ID lists of varying length using chunked, padded IN lists with reading them
+ * using a single statement with one parameter per ID.
+ */
+@interface SCSqliteINListBenchmark : NSObject
+
++ (void)run;
+
+@end
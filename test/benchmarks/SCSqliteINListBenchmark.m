@@ -0,0 +1,97 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCSqliteINListBenchmark.h"
+#import "SCSqlite.h"
+#import "NSArray+SC.h"
+
+/// The number of rows in the benchmark table.
+#define RowCount (100000)
+/// The number of queries measured for each maximum list length.
+#define Iterations (500)
+
+@implementation SCSqliteINListBenchmark
+
++ (void)run {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"SCSqliteINListBenchmark.sqlite"];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    NSError *error = nil;
+    SCSqliteDB *db = [[SCSqliteDB alloc] initWithDBPath:path error:&error];
+    if (error) {
+        NSLog(@"Opening %@: %@", path, error);
+        return;
+    }
+    BOOL ok = [db executeUpdate:@"CREATE TABLE t (id INTEGER PRIMARY KEY, name TEXT)" error:&error];
+    [db beginTransaction:&error];
+    for (NSUInteger i = 0; ok && i < RowCount; i++) {
+        NSArray *params = @[ @(i), [NSString stringWithFormat:@"row %lu", (unsigned long)i] ];
+        ok = [db executeUpdate:@"INSERT INTO t (id, name) VALUES (?, ?)" parameters:params error:&error];
+    }
+    [db commitTransaction:&error];
+    if (!ok) {
+        NSLog(@"Populating benchmark table: %@", error);
+        [db close];
+        return;
+    }
+    NSInteger maxParameterCount = [db maxParameterCount];
+    for (NSNumber *maxLength in @[ @100, @900, @10000 ]) {
+        NSUInteger max = [maxLength unsignedIntegerValue];
+        // List lengths vary between half and all of the maximum, as e.g. the IDs of a changing selection would.
+        NSMutableArray *lists = [[NSMutableArray alloc] initWithCapacity:Iterations];
+        for (NSUInteger i = 0; i < Iterations; i++) {
+            NSUInteger length = max / 2 + (i * 7919) % (max / 2 + 1);
+            NSMutableArray *ids = [[NSMutableArray alloc] initWithCapacity:length];
+            for (NSUInteger j = 0; j < length; j++) {
+                [ids addObject:@(((i + 1) * (j + 1) * 104729) % RowCount)];
+            }
+            [lists addObject:ids];
+        }
+        __block NSUInteger found = 0;
+        NSString *name = [NSString stringWithFormat:@"Read up to %lu IDs, chunked IN list", (unsigned long)max];
+        [SCBenchmark measure:name iterations:Iterations block:^(NSUInteger i) {
+            NSError *queryError = nil;
+            [db enumerateQuery:[NSString stringWithFormat:@"SELECT id, name FROM t WHERE id IN %@", SCSqliteINListMarker]
+                    parameters:nil
+                        inList:lists[i]
+                    usingBlock:^(SCSqliteResultSet *rs, BOOL *stop) {
+                found++;
+            }
+                         error:&queryError];
+        }];
+        if ((NSInteger)max > maxParameterCount) {
+            NSLog(@"Single statement for up to %lu IDs skipped: the parameter limit is %ld", (unsigned long)max, (long)maxParameterCount);
+            continue;
+        }
+        name = [NSString stringWithFormat:@"Read up to %lu IDs, single statement", (unsigned long)max];
+        [SCBenchmark measure:name iterations:Iterations block:^(NSUInteger i) {
+            NSArray *ids = lists[i];
+            NSString *placeholders = [[NSArray arrayWithItem:@"?" repeated:[ids count]] componentsJoinedByString:@","];
+            NSString *sql = [NSString stringWithFormat:@"SELECT id, name FROM t WHERE id IN (%@)", placeholders];
+            NSError *queryError = nil;
+            SCSqliteResultSet *rs = [db executeQuery:sql parameters:ids error:&queryError];
+            while ([rs next]) {
+                found++;
+            }
+            [rs close];
+        }];
+        NSLog(@"%lu rows found; statement cache: %@", (unsigned long)found, [db statementCacheStatistics]);
+    }
+    [db close];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
@@ -0,0 +1,75 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCSqliteIndexedFilterBenchmark.h"
+#import "SCSqlite.h"
+
+/// The number of rows in the benchmark table.
+#define RowCount (100000)
+/// The number of distinct values in the filtered column.
+#define CategoryCount (1000)
+/// The number of filtered queries measured.
+#define QueryCount (1000)
+
+@implementation SCSqliteIndexedFilterBenchmark
+
++ (void)run {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"SCSqliteIndexedFilterBenchmark.sqlite"];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    NSError *error = nil;
+    SCSqliteDB *db = [[SCSqliteDB alloc] initWithDBPath:path error:&error];
+    if (error) {
+        NSLog(@"Opening %@: %@", path, error);
+        return;
+    }
+    BOOL ok = [db executeUpdate:@"CREATE TABLE t (id INTEGER PRIMARY KEY, category INTEGER, name TEXT)" error:&error];
+    [db beginTransaction:&error];
+    for (NSUInteger i = 0; ok && i < RowCount; i++) {
+        NSArray *params = @[ @(i), @((i * 7919) % CategoryCount), [NSString stringWithFormat:@"row %lu", (unsigned long)i] ];
+        ok = [db executeUpdate:@"INSERT INTO t (id, category, name) VALUES (?, ?, ?)" parameters:params error:&error];
+    }
+    [db commitTransaction:&error];
+    if (!ok) {
+        NSLog(@"Populating benchmark table: %@", error);
+        [db close];
+        return;
+    }
+    __block NSUInteger found = 0;
+    void (^query)(NSUInteger) = ^(NSUInteger i) {
+        NSError *queryError = nil;
+        SCSqliteResultSet *rs = [db executeQuery:@"SELECT id, name FROM t WHERE category = ? ORDER BY id"
+                                      parameters:@[ @(i % CategoryCount) ]
+                                           error:&queryError];
+        while ([rs next]) {
+            found++;
+        }
+        [rs close];
+    };
+    [SCBenchmark measure:@"Filter on unindexed column (1k queries)" iterations:QueryCount block:query];
+    // The same index an SCDB table schema would declare as {"indexes":{"t_category":{"columns":["category"]}}}.
+    if (![db executeUpdate:@"CREATE INDEX t_category ON t (category)" error:&error]) {
+        NSLog(@"Creating index: %@", error);
+    }
+    else {
+        [SCBenchmark measure:@"Filter on indexed column (1k queries)" iterations:QueryCount block:query];
+    }
+    NSLog(@"%lu rows found", (unsigned long)found);
+    [db close];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
@@ -0,0 +1,74 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCSqlitePointReadBenchmark.h"
+#import "SCSqlite.h"
+
+/// The number of rows in the benchmark table.
+#define RowCount (1000)
+/// The number of point reads measured.
+#define ReadCount (100000)
+
+@implementation SCSqlitePointReadBenchmark
+
++ (void)run {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"SCSqlitePointReadBenchmark.sqlite"];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    NSError *error = nil;
+    SCSqliteDB *db = [[SCSqliteDB alloc] initWithDBPath:path error:&error];
+    if (error) {
+        NSLog(@"Opening %@: %@", path, error);
+        return;
+    }
+    BOOL ok = [db executeUpdate:@"CREATE TABLE t (id INTEGER PRIMARY KEY, name TEXT, value REAL)" error:&error];
+    [db beginTransaction:&error];
+    for (NSUInteger i = 0; ok && i < RowCount; i++) {
+        NSArray *params = @[ @(i), [NSString stringWithFormat:@"row %lu", (unsigned long)i], @(i * 0.5) ];
+        ok = [db executeUpdate:@"INSERT INTO t (id, name, value) VALUES (?, ?, ?)" parameters:params error:&error];
+    }
+    [db commitTransaction:&error];
+    if (!ok) {
+        NSLog(@"Populating benchmark table: %@", error);
+        [db close];
+        return;
+    }
+    NSMutableArray *ids = [[NSMutableArray alloc] initWithCapacity:RowCount];
+    for (NSUInteger i = 0; i < RowCount; i++) {
+        [ids addObject:@((i * 7919) % RowCount)];
+    }
+    __block NSUInteger found = 0;
+    void (^read)(NSUInteger) = ^(NSUInteger i) {
+        NSError *readError = nil;
+        SCSqliteResultSet *rs = [db executeQuery:@"SELECT * FROM t WHERE id = ?" parameters:@[ ids[i % RowCount] ] error:&readError];
+        if ([rs next]) {
+            found += [rs columnValue:1] != nil;
+        }
+        [rs close];
+    };
+    // Prepare, execute and finalize a statement for every read.
+    db.statementCacheSize = 0;
+    [db clearStatementCache];
+    [SCBenchmark measure:@"Point read, uncached (100k reads)" iterations:ReadCount block:read];
+    // Reset and reuse the cached statement.
+    db.statementCacheSize = 32;
+    [SCBenchmark measure:@"Point read, cached (100k reads)" iterations:ReadCount block:read];
+    NSLog(@"%lu rows found; statement cache: %@", (unsigned long)found, [db statementCacheStatistics]);
+    [db close];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
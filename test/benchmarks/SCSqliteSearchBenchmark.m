@@ -0,0 +1,102 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCSqliteSearchBenchmark.h"
+#import "SCSqlite.h"
+
+/// The number of rows in the benchmark table.
+#define RowCount (20000)
+/// The number of words in each row's body.
+#define WordsPerRow (30)
+/// The number of distinct words.
+#define VocabularySize (5000)
+/// The number of searches measured.
+#define SearchCount (1000)
+
+@implementation SCSqliteSearchBenchmark
+
++ (void)run {
+    if (![SCSqliteDB supportsFTS5]) {
+        NSLog(@"Search benchmark skipped: FTS5 isn't available");
+        return;
+    }
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"SCSqliteSearchBenchmark.sqlite"];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    NSError *error = nil;
+    SCSqliteDB *db = [[SCSqliteDB alloc] initWithDBPath:path error:&error];
+    if (error) {
+        NSLog(@"Opening %@: %@", path, error);
+        return;
+    }
+    // An external content search table kept in step by a trigger, as SCDB creates for a table's search columns.
+    NSArray *schema = @[
+        @"CREATE TABLE docs (id INTEGER PRIMARY KEY, title TEXT, body TEXT)",
+        @"CREATE VIRTUAL TABLE docs_fts USING fts5(title,body,content='docs',content_rowid='rowid')",
+        @"CREATE TRIGGER docs_fts_insert AFTER INSERT ON docs BEGIN "
+         "INSERT INTO docs_fts(rowid,title,body) VALUES (new.rowid,new.title,new.body); END"
+    ];
+    BOOL ok = YES;
+    for (NSString *sql in schema) {
+        ok = ok && [db executeUpdate:sql error:&error];
+    }
+    [db beginTransaction:&error];
+    for (NSUInteger i = 0; ok && i < RowCount; i++) {
+        // Words are "w<n>x", so that no word is a substring of another and LIKE finds the same rows as MATCH.
+        NSMutableArray *words = [[NSMutableArray alloc] initWithCapacity:WordsPerRow];
+        for (NSUInteger w = 0; w < WordsPerRow; w++) {
+            [words addObject:[NSString stringWithFormat:@"w%lux", (unsigned long)((i * 7919 + w * 104729) % VocabularySize)]];
+        }
+        NSArray *params = @[ @(i), [NSString stringWithFormat:@"document %lu", (unsigned long)i], [words componentsJoinedByString:@" "] ];
+        ok = [db executeUpdate:@"INSERT INTO docs (id, title, body) VALUES (?, ?, ?)" parameters:params error:&error];
+    }
+    [db commitTransaction:&error];
+    if (!ok) {
+        NSLog(@"Populating benchmark table: %@", error);
+        [db close];
+        return;
+    }
+    __block NSUInteger found = 0;
+    // The queries SCDB's searchTable:matching:limit: performs, with and without FTS5.
+    [SCBenchmark measure:@"Search, FTS5 MATCH (1k searches)" iterations:SearchCount block:^(NSUInteger i) {
+        NSError *searchError = nil;
+        NSString *match = [NSString stringWithFormat:@"\"w%lux\"", (unsigned long)(i % VocabularySize)];
+        SCSqliteResultSet *rs = [db executeQuery:@"SELECT docs.*, bm25(docs_fts) AS rank FROM docs_fts JOIN docs ON docs.rowid=docs_fts.rowid "
+                                                  "WHERE docs_fts MATCH ? ORDER BY rank LIMIT ?"
+                                      parameters:@[ match, @20 ]
+                                           error:&searchError];
+        while ([rs next]) {
+            found++;
+        }
+        [rs close];
+    }];
+    [SCBenchmark measure:@"Search, LIKE scan (1k searches)" iterations:SearchCount block:^(NSUInteger i) {
+        NSError *searchError = nil;
+        NSString *pattern = [NSString stringWithFormat:@"%%w%lux%%", (unsigned long)(i % VocabularySize)];
+        SCSqliteResultSet *rs = [db executeQuery:@"SELECT * FROM docs WHERE title LIKE ? ESCAPE '\\' OR body LIKE ? ESCAPE '\\' LIMIT ?"
+                                      parameters:@[ pattern, pattern, @20 ]
+                                           error:&searchError];
+        while ([rs next]) {
+            found++;
+        }
+        [rs close];
+    }];
+    NSLog(@"%lu rows found", (unsigned long)found);
+    [db close];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
@@ -0,0 +1,99 @@
+// Copyright 2017 InnerFunction Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//  Copyright © 2026 InnerFunction. All rights reserved.
+//
+
+#import "SCSqliteUpsertBenchmark.h"
+#import "SCSqlite.h"
+
+/// The number of rows in the table before each iteration.
+#define RowCount (5000)
+/// The number of rows upserted by each iteration; half update existing rows, half insert new rows.
+#define UpsertCount (10000)
+/// The number of times each upsert is repeated.
+#define Iterations (10)
+
+@implementation SCSqliteUpsertBenchmark
+
++ (void)run {
+    if (![SCSqliteDB supportsUpsert]) {
+        NSLog(@"Upsert benchmark skipped: SQLite %s doesn't support ON CONFLICT DO UPDATE", sqlite3_libversion());
+        return;
+    }
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"SCSqliteUpsertBenchmark.sqlite"];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    NSError *error = nil;
+    SCSqliteDB *db = [[SCSqliteDB alloc] initWithDBPath:path error:&error];
+    if (error) {
+        NSLog(@"Opening %@: %@", path, error);
+        return;
+    }
+    if (![db executeUpdate:@"CREATE TABLE t (id INTEGER PRIMARY KEY, name TEXT, value REAL)" error:&error]) {
+        NSLog(@"Creating benchmark table: %@", error);
+        [db close];
+        return;
+    }
+    NSMutableArray *rows = [[NSMutableArray alloc] initWithCapacity:UpsertCount];
+    for (NSUInteger i = 0; i < UpsertCount; i++) {
+        [rows addObject:@[ @(i), [NSString stringWithFormat:@"upserted %lu", (unsigned long)i], @(i * 0.25) ]];
+    }
+    __block BOOL ok = YES;
+    // Restore the table's initial rows; run at the start of each iteration, so that both methods do the same work.
+    void (^populate)(void) = ^{
+        NSError *populateError = nil;
+        ok &= [db executeUpdate:@"DELETE FROM t" error:&populateError];
+        for (NSUInteger i = 0; i < RowCount; i++) {
+            NSArray *params = @[ @(i), [NSString stringWithFormat:@"row %lu", (unsigned long)i], @(i * 0.5) ];
+            ok &= [db executeUpdate:@"INSERT INTO t (id, name, value) VALUES (?, ?, ?)" parameters:params error:&populateError];
+        }
+    };
+    [SCBenchmark measure:@"Upsert 10k rows, count then update or insert" iterations:Iterations block:^(NSUInteger i) {
+        NSError *upsertError = nil;
+        ok &= [db beginTransaction:&upsertError];
+        populate();
+        for (NSArray *row in rows) {
+            SCSqliteResultSet *rs = [db executeQuery:@"SELECT count(*) FROM t WHERE id = ?" parameters:@[ row[0] ] error:&upsertError];
+            BOOL exists = [rs next] && [rs columnValueAsInteger:0] == 1;
+            [rs close];
+            if (exists) {
+                NSArray *params = @[ row[1], row[2], row[0] ];
+                ok &= [db executeUpdate:@"UPDATE t SET name = ?, value = ? WHERE id = ?" parameters:params error:&upsertError];
+            }
+            else {
+                ok &= [db executeUpdate:@"INSERT INTO t (id, name, value) VALUES (?, ?, ?)" parameters:row error:&upsertError];
+            }
+        }
+        ok &= [db commitTransaction:&upsertError];
+    }];
+    [SCBenchmark measure:@"Upsert 10k rows, native upsert" iterations:Iterations block:^(NSUInteger i) {
+        NSError *upsertError = nil;
+        ok &= [db beginTransaction:&upsertError];
+        populate();
+        for (NSArray *row in rows) {
+            ok &= [db executeUpdate:@"INSERT INTO t (id, name, value) VALUES (?, ?, ?) "
+                                     "ON CONFLICT(id) DO UPDATE SET name = excluded.name, value = excluded.value"
+                         parameters:row
+                              error:&upsertError];
+        }
+        ok &= [db commitTransaction:&upsertError];
+    }];
+    if (!ok) {
+        NSLog(@"Upsert benchmark had write errors; results aren't valid");
+    }
+    [db close];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end